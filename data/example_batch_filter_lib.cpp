@@ -0,0 +1,12 @@
+#include <pawn_plugin.h>
+
+extern "C" unsigned pawnAbiVersion() { return PAWN_ABI_VERSION; }
+
+// keeps the rows with the second numeric column greater than 5
+extern "C" void fn(const pawnBatch *b, uint64_t *sel) {
+  if (b->nNum < 2) return;
+  const double *col = b->num + b->rows;
+  for (size_t r = 0; r < b->rows; ++r) {
+    if (col[r] > 5.0) sel[r / 64] |= uint64_t(1) << (r % 64);
+  }
+}
@@ -0,0 +1,30 @@
+#include <math.h>
+#include <pawn_plugin.h>
+
+extern "C" unsigned pawnAbiVersion() { return PAWN_ABI_VERSION; }
+
+// $h = cmd "./udf.so" hypot($a, $b)
+extern "C" void hypot2(const pawnBatch *b, double *out) {
+  const double *x = b->num;
+  const double *y = b->num + b->rows;
+  for (size_t r = 0; r < b->rows; ++r) out[r] = sqrt(x[r] * x[r] + y[r] * y[r]);
+}
+
+// reduce %k cmd "./udf.so" mean($a), the state is the sum and the count
+extern "C" size_t mean_size() { return 2; }
+
+extern "C" void mean_init(double *state) { state[0] = state[1] = 0.; }
+
+extern "C" void mean_update(double *state, const pawnBatch *b) {
+  for (size_t r = 0; r < b->rows; ++r) state[0] += b->num[r];
+  state[1] += b->rows;
+}
+
+extern "C" void mean_merge(double *state, const double *other) {
+  state[0] += other[0];
+  state[1] += other[1];
+}
+
+extern "C" double mean_final(const double *state) {
+  return state[1] > 0 ? state[0] / state[1] : 0.;
+}
@@ -65,6 +65,7 @@ public:
   // if the rows need to be sent to the user function in sliding window
   // fashion once they reach a certain number. Useful for grouping adjacent rows
   // by ordering such as in central difference, trajectory directions etc.
+  // A UDF that takes ezl::Window in place of vector slides in constant time.
   // @param bunchSize the size of the window or number of rows to bunch together
   // @param fixed whether to call when rows are lesser than window size or not as
   //              during the beginning or ending of the rows.
@@ -118,7 +119,7 @@ public:
     _prev = PrllExpr<ReduceAllBuilder>::_preBuild(_prev, P{}, std::forward<H>(_h));
     auto ordered = this->getOrdered();
     auto obj = std::make_shared<ReduceAll<meta::ReduceAllTypes<I, P, S, F, O>>>(
-        std::forward<F>(_func), ordered, _adjacent, _fixed, _bunchSize);
+        std::forward<F>(_func), ordered, _adjacent, _bunchSize, _fixed);
     obj->prev(_prev, obj);
     DumpExpr<ReduceAllBuilder, O>::_postBuild(obj);
     return obj;
@@ -38,9 +38,11 @@ template <class I, class S, class F, class FO, class O, class P, class H, class
 struct ReduceBuilder : RSUPER {
 public:
   ReduceBuilder(F &&f, FO &&initVal, std::shared_ptr<Source<I>> prev,
-                Flow<A, std::nullptr_t> a, bool scan, H &&h = H{})
+                Flow<A, std::nullptr_t> a, bool scan, H &&h = H{}, size_t budget = 0,
+                bool partial = false, size_t *peak = nullptr)
       : _func{std::forward<F>(f)}, _prev{prev}, _scan{scan},
-        _initVal{std::forward<FO>(initVal)}, _h{std::forward<H>(h)} {
+        _initVal{std::forward<FO>(initVal)}, _h{std::forward<H>(h)}, _budget{budget},
+        _partial{partial}, _peak{peak} {
     this->prll(Karta::prllRatio); 
     this->_fl = a;
   }
@@ -55,6 +57,37 @@ public:
     return *this;
   }
 
+  /*!
+   * limits the bytes that the groups take in a process, partitions of the
+   * groups are spilled to temporary files when these are more.
+   * @param budget bytes, zero for no limit
+   * */
+  auto spill(size_t budget) {
+    _budget = budget;
+    return *this;
+  }
+
+  /*!
+   * marks the reduce as partial i.e. its groups are reduced again by a later
+   * reduce, so it may pass the rows on without keeping them in the table
+   * when nearly every key is new.
+   * @param isPartial optional boolean
+   * */
+  auto partial(bool isPartial = true) {
+    _partial = isPartial;
+    return *this;
+  }
+
+  /*!
+   * the most groups the table holds at once in the process are kept in the
+   * pointed value, for reporting.
+   * @param peak pointer to the count, nullptr to not keep it
+   * */
+  auto peak(size_t *peak) {
+    _peak = peak;
+    return *this;
+  }
+
   /*!
    * internally called by cols and colsDrop
    * @param NO template param for selection columns 
@@ -64,7 +97,7 @@ public:
   auto colsSlct(NO = NO{}) {
     auto temp = ReduceBuilder<I, S, F, FO, NO, P, H, A>{
         std::forward<F>(_func), std::forward<FO>(_initVal), std::move(_prev),
-        std::move(this->_fl), _scan, std::forward<H>(_h)};
+        std::move(this->_fl), _scan, std::forward<H>(_h), _budget, _partial, _peak};
     temp.prllProps(this->prllProps());
     temp.dumpProps(this->dumpProps());
     return temp;
@@ -79,7 +112,7 @@ public:
   auto partitionBy(NH &&nh) {
     auto temp = ReduceBuilder<I, S, F, FO, O, P, NH, A>{
         std::forward<F>(_func), std::forward<FO>(_initVal), std::move(_prev),
-        std::move(this->_fl), _scan, std::forward<NH>(nh)};
+        std::move(this->_fl), _scan, std::forward<NH>(nh), _budget, _partial, _peak};
     temp.prllProps(this->prllProps());
     temp.dumpProps(this->dumpProps());
     return temp;
@@ -94,7 +127,7 @@ public:
     auto ordered = this->getOrdered();
     auto obj =
         std::make_shared<Reduce<meta::ReduceTypes<I, P, S, F, FO, O>>>(
-            std::forward<F>(_func), std::forward<FO>(_initVal), _scan, ordered);
+            std::forward<F>(_func), std::forward<FO>(_initVal), _scan, ordered, _budget, _partial, _peak);
     obj->prev(_prev, obj);
     DumpExpr<ReduceBuilder, O>::_postBuild(obj);
     return obj;
@@ -119,6 +152,9 @@ private:
   bool _scan{false};
   FO _initVal;
   H _h;
+  size_t _budget{0};
+  bool _partial{false};
+  size_t *_peak{nullptr};
 };
 }
 } // namespace ezl namespace ezl::detail
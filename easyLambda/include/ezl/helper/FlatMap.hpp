@@ -0,0 +1,171 @@
+/*!
+ * @file
+ * class FlatMap, open addressing hash table for the keyed units.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+#ifndef FLATMAP_EZL_H
+#define FLATMAP_EZL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ezl {
+namespace detail {
+
+/*!
+ * @ingroup helper
+ * Hash table with the entries kept contiguous in insertion order and a
+ * separate linear probing array of slots, each with the full hash and the
+ * position of its entry. A probe compares the stored hashes and touches an
+ * entry only when the hash matches, so keys such as vectors of strings are
+ * hashed once per row and compared about once per lookup. Growing and erase
+ * use the hashes kept along with the entries and never hash a key again.
+ *
+ * Lookup takes any type that hashes and compares equal to the key, as
+ * `find(key, hash, eq)` of `boost::unordered_map` does, e.g. a tuple of
+ * references to the columns of the incoming row.
+ *
+ * Iterators are pointers to the entries, they are invalidated by insertion
+ * and erase moves the last entry in place of the erased one.
+ * */
+template <class K, class V, class Hash, class Eq>
+class FlatMap {
+public:
+  using value_type = std::pair<K, V>;
+  using iterator = value_type *;
+  using const_iterator = const value_type *;
+
+  iterator begin() { return _entries.data(); }
+  iterator end() { return _entries.data() + _entries.size(); }
+  const_iterator begin() const { return _entries.data(); }
+  const_iterator end() const { return _entries.data() + _entries.size(); }
+  size_t size() const { return _entries.size(); }
+  bool empty() const { return _entries.empty(); }
+
+  template <class Q> size_t hash(const Q &key) const { return _stored(_hash(key)); }
+
+  /*!
+   * brings the cache line of the first slot to probe for the hash, for
+   * looking up a batch of rows with the probes overlapped.
+   * */
+  void prefetch(size_t h) const {
+    if (!_slots.empty()) __builtin_prefetch(&_slots[_home(h)]);
+  }
+
+  template <class Q> iterator find(const Q &key) { return find(key, hash(key)); }
+
+  template <class Q> iterator find(const Q &key, size_t h) {
+    if (_entries.empty()) return end();
+    for (auto i = _home(h); _slots[i].hash; i = (i + 1) & _mask) {
+      if (_slots[i].hash == h && _eq(_entries[_slots[i].pos].first, key)) {
+        return &_entries[_slots[i].pos];
+      }
+    }
+    return end();
+  }
+
+  /*!
+   * adds an entry with the key and the value, the key must not be present
+   * and `h` must be `hash(key)`.
+   * */
+  template <class Q, class W> iterator emplace(const Q &key, size_t h, W &&val) {
+    if ((_entries.size() + 1) * 4 > _slots.size() * 3) _grow();
+    auto i = _home(h);
+    while (_slots[i].hash) i = (i + 1) & _mask;
+    _slots[i] = Slot{h, _entries.size()};
+    _entries.emplace_back(K(key), std::forward<W>(val));
+    _hashes.push_back(h);
+    return &_entries.back();
+  }
+
+  /*!
+   * removes the entry and returns the iterator at its position, that now has
+   * the entry that was last or is the end.
+   * */
+  iterator erase(iterator it) {
+    auto pos = size_t(it - begin());
+    auto i = _slotOf(pos);
+    // backward shift the run that follows so that no probe finds a hole
+    for (auto j = (i + 1) & _mask; _slots[j].hash; j = (j + 1) & _mask) {
+      auto home = _home(_slots[j].hash);
+      if (((j - home) & _mask) >= ((j - i) & _mask)) {
+        _slots[i] = _slots[j];
+        i = j;
+      }
+    }
+    _slots[i] = Slot{};
+    auto last = _entries.size() - 1;
+    if (pos != last) {
+      _slots[_slotOf(last)].pos = pos;
+      _entries[pos] = std::move(_entries[last]);
+      _hashes[pos] = _hashes[last];
+    }
+    _entries.pop_back();
+    _hashes.pop_back();
+    return begin() + pos;
+  }
+
+  void clear() {
+    _entries.clear();
+    _hashes.clear();
+    _slots.clear();
+    _mask = 0;
+    _shift = 64;
+  }
+
+private:
+  // zero marks an empty slot
+  struct Slot {
+    size_t hash{0};
+    size_t pos{0};
+  };
+
+  static size_t _stored(size_t h) { return h | 1; }
+
+  // fibonacci hashing so that the weak low bits of the hash do not matter
+  size_t _home(size_t h) const {
+    return size_t((uint64_t(h) * 0x9E3779B97F4A7C15ull) >> _shift);
+  }
+
+  size_t _slotOf(size_t pos) const {
+    auto i = _home(_hashes[pos]);
+    while (_slots[i].pos != pos || !_slots[i].hash) i = (i + 1) & _mask;
+    return i;
+  }
+
+  void _grow() {
+    auto n = _slots.empty() ? size_t(16) : _slots.size() * 2;
+    _shift = 64;
+    for (auto m = n; m > 1; m >>= 1) --_shift;
+    _mask = n - 1;
+    std::vector<Slot> slots(n);
+    for (const auto &it : _slots) {
+      if (!it.hash) continue;
+      auto i = _home(it.hash);
+      while (slots[i].hash) i = (i + 1) & _mask;
+      slots[i] = it;
+    }
+    _slots = std::move(slots);
+    _entries.reserve(n / 4 * 3);
+  }
+
+  std::vector<value_type> _entries;
+  std::vector<size_t> _hashes;
+  std::vector<Slot> _slots;
+  size_t _mask{0};
+  int _shift{64};
+  Hash _hash;
+  Eq _eq;
+};
+}
+} // namespace ezl ezl::detail
+
+#endif // !FLATMAP_EZL_H
@@ -0,0 +1,125 @@
+/*!
+ * @file
+ * class SpillFile and function heapBytes, for units that keep their state
+ * within a memory budget.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+#ifndef SPILL_EZL_H
+#define SPILL_EZL_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <ezl/helper/meta/serializeTuple.hpp>
+
+namespace ezl {
+namespace detail {
+
+/*!
+ * estimate of the bytes a value has on the heap, besides its own size.
+ * */
+template <class T> size_t heapBytes(const T &);
+inline size_t heapBytes(const std::string &s);
+template <class T, class A> size_t heapBytes(const std::vector<T, A> &v);
+template <class... Ts> size_t heapBytes(const std::tuple<Ts...> &t);
+
+template <class T> size_t heapBytes(const T &) { return 0; }
+
+// short strings are kept within the object
+inline size_t heapBytes(const std::string &s) {
+  return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+template <class T, class A> size_t heapBytes(const std::vector<T, A> &v) {
+  auto res = v.capacity() * sizeof(T);
+  for (const auto &it : v) res += heapBytes(it);
+  return res;
+}
+
+template <class Tup, size_t... Is>
+size_t _tupleHeapBytes(const Tup &t, std::index_sequence<Is...>) {
+  size_t res = 0;
+  (void)std::initializer_list<int>{(res += heapBytes(std::get<Is>(t)), 0)...};
+  return res;
+}
+
+template <class... Ts> size_t heapBytes(const std::tuple<Ts...> &t) {
+  return _tupleHeapBytes(t, std::index_sequence_for<Ts...>{});
+}
+
+/*!
+ * @ingroup helper
+ * Temporary file of records in a binary archive that are read back in the
+ * order they are written. The file is in `TMPDIR` or else in /tmp and is
+ * unlinked as soon as it is opened, so nothing is left behind if the
+ * process dies.
+ * */
+class SpillFile {
+public:
+  SpillFile() {
+    auto dir = std::getenv("TMPDIR");
+    std::string path = std::string{dir ? dir : "/tmp"} + "/ezlspillXXXXXX";
+    std::vector<char> name(begin(path), end(path));
+    name.push_back('\0');
+    auto fd = mkstemp(name.data());
+    if (fd == -1) throw std::runtime_error("can not create a spill file like " + path);
+    _file.open(name.data(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    close(fd);
+    std::remove(name.data());
+    if (!_file) throw std::runtime_error("can not open the spill file " + std::string{name.data()});
+    _out = std::make_unique<boost::archive::binary_oarchive>(_file, boost::archive::no_header);
+  }
+
+  // writes a record of the values
+  template <class... Ts> void write(const Ts &... xs) {
+    (void)std::initializer_list<int>{(*_out << xs, 0)...};
+    ++_count;
+  }
+
+  // records written, to be read after rewind
+  size_t count() const { return _count; }
+
+  // ends the writing, the records can then be read from the first
+  void rewind() {
+    _out.reset();
+    _file.flush();
+    _file.seekg(0);
+    _in = std::make_unique<boost::archive::binary_iarchive>(_file, boost::archive::no_header);
+  }
+
+  template <class... Ts> void read(Ts &... xs) {
+    (void)std::initializer_list<int>{(*_in >> xs, 0)...};
+  }
+
+private:
+  std::fstream _file;
+  std::unique_ptr<boost::archive::binary_oarchive> _out;
+  std::unique_ptr<boost::archive::binary_iarchive> _in;
+  size_t _count{0};
+};
+}
+} // namespace ezl ezl::detail
+
+#endif // !SPILL_EZL_H
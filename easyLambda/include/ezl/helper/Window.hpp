@@ -0,0 +1,73 @@
+/*!
+ * @file
+ * class Window, rows of a sliding window that are contiguous in memory.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+#ifndef WINDOW_EZL_H
+#define WINDOW_EZL_H
+
+#include <cassert>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace ezl {
+
+/*!
+ * @ingroup helper
+ * Read only view of the rows of a sliding window, for a reduce-all UDF to
+ * take in place of a vector. The rows that leave the front are not erased
+ * one by one, they are skipped and erased together once they are as many as
+ * the rows in the window. Each row is thus moved a constant number of times
+ * and a window slides in amortized constant time per row, while a vector
+ * moves all of its rows for every row that comes in.
+ *
+ * e.g. `[](const std::tuple<int>& key, const ezl::Window<std::tuple<double>>& rows)`
+ * or `[](int key, const ezl::Window<double>& xs)` with `adjacent`.
+ * */
+template <class T> class Window {
+public:
+  using value_type = T;
+  using size_type = typename std::vector<T>::size_type;
+  using const_iterator = typename std::vector<T>::const_iterator;
+  using iterator = const_iterator;
+  using const_reference = typename std::vector<T>::const_reference;
+  using reference = const_reference;
+
+  const_iterator begin() const { return std::begin(_rows) + _first; }
+  const_iterator end() const { return std::end(_rows); }
+  size_type size() const { return _rows.size() - _first; }
+  bool empty() const { return size() == 0; }
+  const_reference operator[](size_type i) const { return _rows[_first + i]; }
+  const_reference front() const { return _rows[_first]; }
+  const_reference back() const { return _rows.back(); }
+
+  template <class... Args> void emplace_back(Args &&... args) {
+    _rows.emplace_back(std::forward<Args>(args)...);
+  }
+
+  void pop_front() {
+    assert(!empty());
+    if (++_first * 2 < _rows.size()) return;
+    _rows.erase(std::begin(_rows), std::begin(_rows) + _first);
+    _first = 0;
+  }
+
+  void clear() {
+    _rows.clear();
+    _first = 0;
+  }
+
+private:
+  std::vector<T> _rows;
+  size_type _first{0};
+};
+} // namespace ezl
+
+#endif // !WINDOW_EZL_H
@@ -1,7 +1,8 @@
 /*!
  * @file
  * overloaded functions to provide same interface for push, clear... in 
- * tuple<vector, vec..> (SOA) and vector<tuple<...>> (AOS)
+ * tuple<vector, vec..> (SOA) and vector<tuple<...>> (AOS), and the same with
+ * ezl::Window in place of vector.
  *
  * This file is a part of easyLambda(ezl) project for parallel data
  * processing with modern C++ and MPI.
@@ -13,10 +14,14 @@
 #ifndef COHERENTVECTOR_EZL_H
 #define COHERENTVECTOR_EZL_H
 
+#include <cassert>
+#include <initializer_list>
 #include <vector>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
+#include <ezl/helper/Window.hpp>
 #include <ezl/helper/meta/slct.hpp>
 
 namespace ezl {
@@ -113,6 +118,67 @@ template <typename... Is>
 auto coherentSize(const std::vector<std::tuple<Is...>> &v) {
   return int(v.size());
 }
+
+// ezl::Window, a pop from the front is amortized constant
+template <typename... Is, size_t... Ns>
+void coherentPushImpl(std::tuple<Window<Is>...> &v, const std::tuple<Is...> &t,
+                      std::index_sequence<Ns...>) {
+  (void)std::initializer_list<int>{(std::get<Ns>(v).emplace_back(std::get<Ns>(t)), 0)...};
+}
+
+template <typename... Is>
+auto coherentPush(std::tuple<Window<Is>...> &v, const std::tuple<Is...> &t) {
+  coherentPushImpl(v, t, std::index_sequence_for<Is...>{});
+  return int(std::get<0>(v).size());
+}
+
+template <typename... Is>
+auto coherentPush(Window<std::tuple<Is...>> &v, const std::tuple<Is...> &t) {
+  v.emplace_back(t);
+  return int(v.size());
+}
+
+template <typename... Is, size_t... Ns>
+void coherentPopFrontImpl(std::tuple<Window<Is>...> &v, std::index_sequence<Ns...>) {
+  (void)std::initializer_list<int>{(std::get<Ns>(v).pop_front(), 0)...};
+}
+
+template <typename... Is>
+auto coherentPopFront(std::tuple<Window<Is>...> &v) {
+  coherentPopFrontImpl(v, std::index_sequence_for<Is...>{});
+  return int(std::get<0>(v).size());
+}
+
+template <typename... Is>
+auto coherentPopFront(Window<std::tuple<Is...>> &v) {
+  v.pop_front();
+  return int(v.size());
+}
+
+template <typename... Is, size_t... Ns>
+void coherentClearImpl(std::tuple<Window<Is>...> &v, std::index_sequence<Ns...>) {
+  (void)std::initializer_list<int>{(std::get<Ns>(v).clear(), 0)...};
+}
+
+template <typename... Is>
+auto coherentClear(std::tuple<Window<Is>...> &v) {
+  coherentClearImpl(v, std::index_sequence_for<Is...>{});
+}
+
+template <typename... Is>
+auto coherentClear(Window<std::tuple<Is...>> &v) {
+  v.clear();
+}
+
+template <typename... Is>
+auto coherentSize(const std::tuple<Window<Is>...> &v) {
+  return int(std::get<0>(v).size());
+}
+
+template <typename... Is>
+auto coherentSize(const Window<std::tuple<Is...>> &v) {
+  return int(v.size());
+}
 }
 }
 } // namespace ezl detail meta
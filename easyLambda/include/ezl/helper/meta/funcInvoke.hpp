@@ -2,7 +2,7 @@
  * @file
  * functions to invoke a function with params as tuple expanded or unexpanded
  * for map and reduce with uniform interface. For reduceAll vector of tuple or
- * tuple of vectors expanded or unexpanded.
+ * tuple of vectors expanded or unexpanded, or the same with ezl::Window.
  *
  * This file is a part of easyLambda(ezl) project for parallel data
  * processing with modern C++ and MPI.
@@ -18,6 +18,7 @@
 #include <tuple>
 #include <type_traits>
 
+#include <ezl/helper/Window.hpp>
 #include <ezl/helper/meta/slct.hpp>
 
 namespace ezl {
@@ -167,6 +168,27 @@ auto invokeReduceAll(
       "reduceAll fn. can not be called with columns selected as parameters.");
 }
 
+// reduce-all AOS with sliding window calls key as separate arguments
+template <class F, class... Ks, class... Vs>
+inline decltype(auto) invokeReduceAll(F &&func, const std::tuple<Ks...> &key,
+            const Window<std::tuple<Vs...>> &val,
+            typename std::enable_if<can_call<F, Ks..., decltype(val)>{}
+            && !can_call<F, decltype(key), decltype(val)>{}
+            >::type *
+                dummy = 0) {
+  return invokeHelperOneTup(std::forward<F>(func), key,
+                       std::make_index_sequence<sizeof...(Ks)>{}, val);
+}
+
+// reduce-all AOS with sliding window and key as tuple
+template <class F, class... Ks, class... Vs>
+inline decltype(auto) invokeReduceAll(F &&f, const std::tuple<Ks...> &key,
+            const Window<std::tuple<Vs...>> &val,
+            typename std::enable_if< 
+                can_call<F, decltype(key), decltype(val)>{}>::type *dummy = 0) {
+  return f(key, val);
+}
+
 // reduce-all SOA with key as well as value as tuple
 template <class F, class... Ks, class... Vs>
 inline decltype(auto) invokeReduceAll(F &&f, const std::tuple<Ks...> &key, const std::tuple<Vs...> &val,
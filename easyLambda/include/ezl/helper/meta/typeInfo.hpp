@@ -16,6 +16,7 @@
 #include <tuple>
 #include <type_traits>
 
+#include <ezl/helper/Window.hpp>
 #include <ezl/helper/meta/funcInvoke.hpp>
 #include <ezl/helper/meta/slctTuple.hpp>
 #include <ezl/helper/meta/slct.hpp>
@@ -150,6 +151,26 @@ struct BufType<
   using type = std::vector<std::tuple<Vs...>>;
 };
 
+// buffer type for SOA with sliding windows
+template <typename F, typename... Ks, typename... Vs>
+struct BufType<
+    F, std::tuple<Ks...>, std::tuple<Vs...>,
+    typename std::enable_if<(
+        can_call<F, std::tuple<Ks...>, std::tuple<Window<Vs>...>>{} ||
+        can_call<F, Ks..., Window<Vs>...>{})>::type> {
+  using type = std::tuple<Window<Vs>...>;
+};
+
+// buffer type for AOS with sliding windows
+template <typename F, typename... Ks, typename... Vs>
+struct BufType<
+    F, std::tuple<Ks...>, std::tuple<Vs...>,
+    typename std::enable_if<(
+        can_call<F, std::tuple<Ks...>, Window<std::tuple<Vs...>>>{} ||
+        can_call<F, Ks..., Window<std::tuple<Vs...>>>{})>::type> {
+  using type = Window<std::tuple<Vs...>>;
+};
+
 // a collection of types for getting type info for reduce-all with default
 // output selection input data type, selection and function.
 template <class I, class Kslct, class Fslct, class Func> 
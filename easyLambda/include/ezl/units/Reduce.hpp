@@ -12,12 +12,17 @@
 #ifndef REDUCE_EZL_H
 #define REDUCE_EZL_H
 
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <tuple>
 #include <vector>
 
-#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <ezl/pipeline/Link.hpp>
+#include <ezl/helper/FlatMap.hpp>
+#include <ezl/helper/Spill.hpp>
 #include <ezl/helper/meta/funcInvoke.hpp>
 #include <ezl/helper/meta/slctTuple.hpp>
 #include <ezl/helper/meta/typeInfo.hpp>
@@ -43,6 +48,24 @@ namespace detail {
  *
  * See examples for using with builders or unittests for direct use.
  *
+ * With a memory budget the table is split in partitions on the hash of the
+ * key. When the entries are over the budget the partition with the most
+ * bytes is spilled, its groups are written to a temporary file and the
+ * later rows for it are written as they are to another. At the end the
+ * groups in memory are passed on first, then each spilled partition is
+ * read back in a table of its own and the rows are reduced on the groups,
+ * so the UDF need not merge two results. A partition read back is held to
+ * the budget as well, split again on another slice of the hash, down to a
+ * few levels after which a partition is kept whole. The scan and ordered
+ * modes do not spill.
+ *
+ * A partial reduce is one whose groups are combined again by a later reduce,
+ * so it may pass a group on more than once. It counts the new groups in
+ * each window of rows and if nearly every row is a new group the table is
+ * passed on and emptied, the rows are then passed on reduced on their own
+ * without a lookup. A window is sampled in the table again every so many
+ * rows to see if the keys repeat by then.
+ *
  * */
 template <class TypeInfo>
 struct Reduce : public Link<typename TypeInfo::itype, typename TypeInfo::otype> {
@@ -62,20 +85,109 @@ public:
   using ktype = typename TypeInfo::ktype;
   using otype = typename TypeInfo::otype;
   using kref = typename TypeInfo::kreftype;
+  using vref = typename TypeInfo::vtype;
+  using vtype = typename meta::SlctTupleType<itype, Vslct>::type;
   using HashScheme = boost::hash<kref>;
-  using maptype =  boost::unordered_map<ktype, FO>;
+  using maptype = FlatMap<ktype, FO, HashScheme, EqWrapper>;
 
   static constexpr int osize = std::tuple_size<otype>::value;
 
-  Reduce(F f, FO val, bool scan, bool order) : _func(f), _initVal(val), _scan(scan), _ordered(order) {}
+  static constexpr size_t nParts = 16;
+
+  // levels of partitions under a spilled one, beyond these it is not split
+  static constexpr size_t nLevels = 4;
+
+  // rows in a window of a partial reduce, the windows sampled in the table
+  // after it is bypassed and the share of new groups in a window to bypass
+  static constexpr size_t window = 4096;
+  static constexpr size_t bypassWindows = 16;
+  static constexpr double bypassRatio = 0.9;
+
+  // peak, if given, is kept at the most groups in the table at once
+  Reduce(F f, FO val, bool scan, bool order, size_t budget = 0, bool partial = false,
+         size_t *peak = nullptr)
+      : _func(f), _initVal(val), _scan(scan), _ordered(order),
+        _budget{(scan || order) ? 0 : budget}, _partial{partial && !scan && !order},
+        _peak{peak} {}
 
   virtual void dataEvent(const itype &data) final override {
     kref curKey = meta::slctTupleRef(data, Kslct{});
+    _process(data, curKey, _index.hash(curKey));
+  }
+
+  /*!
+   * the keys of a batch of rows are hashed first and the table slots for all
+   * of them are prefetched before any of the rows is reduced.
+   * */
+  virtual void dataEvent(const std::vector<itype> &vData) final override {
+    std::vector<size_t> hashes;
+    hashes.reserve(vData.size());
+    for (const auto &it : vData) {
+      hashes.push_back(_index.hash(meta::slctTupleRef(it, Kslct{})));
+      _index.prefetch(hashes.back());
+    }
+    auto h = std::begin(hashes);
+    for (const auto &it : vData) {
+      _process(it, meta::slctTupleRef(it, Kslct{}), *h++);
+    }
+  }
+
+private:
+  void _process(const itype &data, const kref &curKey, size_t hash) {
     auto curVal = meta::slctTupleRef(data, Vslct{});
-    auto it = _index.find(curKey, _hash, _eq);
+    if (_bypass) return _pass(curKey, curVal);
+    if (_nSpilled > 0) {
+      auto &part = _parts[_part(hash)];
+      if (part.rows) {
+        part.rows->write(ktype(curKey), vtype(curVal));
+        return;
+      }
+    }
+    auto n = _index.size();
+    _fold(curKey, curVal, hash);
+    if (_partial) _sample(_index.size() > n);
+  }
+
+  void _sample(bool isNew) {
+    _nNew += isNew;
+    if (++_nWindow < window) return;
+    if (_nNew >= bypassRatio * window) {
+      callEm<FO>();
+      _index.clear();
+      _bytes = 0;
+      for (auto &it : _parts) it.bytes = 0;
+      _bypass = true;
+    }
+    _nWindow = _nNew = 0;
+  }
+
+  // the row reduced on its own is passed on
+  void _pass(const kref &curKey, const vref &curVal) {
+    if (++_nWindow == window * bypassWindows) {
+      _bypass = false;
+      _nWindow = 0;
+    }
+    if (TypeInfo::isRefRes) {
+      FO res{_initVal};
+      decltype(auto) x = meta::invokeReduce(_func, res, curKey, curVal);
+      callKey<FO>(curKey, x);
+    } else {
+      callKey<FO>(curKey, meta::invokeReduce(_func, _initVal, curKey, curVal));
+    }
+  }
+
+  void _fold(const kref &curKey, const vref &curVal, size_t hash) {
+    auto n = _index.size();
+    // in ordered mode only the current group is in the table, it is emitted
+    // and erased when a row of another group arrives
+    if (_ordered && !_scan && !_index.empty() && !_eq(std::begin(_index)->first, curKey)) {
+      callKey<FO>(std::begin(_index)->first, std::begin(_index)->second);
+      _index.erase(std::begin(_index));
+    }
+    auto it = _index.find(curKey, hash);
     if(TypeInfo::isRefRes) {
       if (it == std::end(_index)) {
-        it = _index.emplace_hint(it, ktype(curKey), _initVal);
+        it = _index.emplace(curKey, hash, _initVal);
       } 
       decltype(auto) x = meta::invokeReduce(_func, it->second, curKey, curVal);
       if (&x != &it->second) {
@@ -85,30 +197,127 @@ public:
       if (it != std::end(_index)) {
         it->second = meta::invokeReduce(_func, it->second, curKey, curVal);
       } else {
-        it = _index.emplace_hint(it, ktype(curKey),
+        it = _index.emplace(curKey, hash,
                 meta::invokeReduce(_func, _initVal, curKey, curVal));
       }
     }
-    if (_scan) {
-      callKey<FO>(it);
-      return;
-    }
-    if (_ordered) { 
-      if (_first) {
-        _first = false;
-        _preIt = it;
-      } else if (_preIt->first != curKey) {
-        callKey<FO>(_preIt);
-        _index.erase(_preIt);
-        _preIt = it;
+    if (_scan) callKey<FO>(it->first, it->second);
+    if (_index.size() > n) _grown();
+    if (_budget && _index.size() > n) _account(it, hash);
+  }
+
+  void _grown() {
+    if (_peak && _index.size() > *_peak) *_peak = _index.size();
+  }
+
+  struct Part {
+    size_t bytes{0};
+    std::unique_ptr<SpillFile> groups;
+    std::unique_ptr<SpillFile> rows;
+  };
+
+  // the partitions under a spilled one are on another slice of the hash
+  size_t _part(size_t hash) const {
+    if (_level > 0) boost::hash_combine(hash, _level);
+    return (hash >> 32) % nParts;
+  }
+
+  // the entry, its slot in the table and what its key and result hold
+  void _account(typename maptype::iterator it, size_t hash) {
+    auto b = sizeof(*it) + 2 * sizeof(size_t) + heapBytes(it->first) + heapBytes(it->second);
+    _parts[_part(hash)].bytes += b;
+    _bytes += b;
+    if (_bytes > _budget && _level < nLevels) _spill();
+  }
+
+  void _spill() {
+    while (_bytes > _budget) {
+      auto p = std::max_element(std::begin(_parts), std::end(_parts),
+                                [](const Part &a, const Part &b) { return a.bytes < b.bytes; });
+      if (p->bytes == 0) return;
+      auto i = size_t(p - std::begin(_parts));
+      p->groups = std::make_unique<SpillFile>();
+      p->rows = std::make_unique<SpillFile>();
+      for (auto it = std::begin(_index); it != std::end(_index);) {
+        if (_part(_index.hash(it->first)) != i) {
+          ++it;
+          continue;
+        }
+        p->groups->write(it->first, it->second);
+        it = _index.erase(it);
       }
+      _bytes -= p->bytes;
+      p->bytes = 0;
+      ++_nSpilled;
     }
   }
-private:
+
+  // the groups of a spilled partition are read back and the rows that came
+  // after are reduced on them, the groups and the rows of a partition under
+  // it that is spilled in turn are written on for it
+  void _unspill(Part &p) {
+    p.groups->rewind();
+    for (size_t i = 0; i < p.groups->count(); ++i) {
+      ktype k;
+      FO v{_initVal};
+      p.groups->read(k, v);
+      auto hash = _index.hash(k);
+      auto &sub = _parts[_part(hash)];
+      if (sub.groups) {
+        sub.groups->write(k, v);
+        continue;
+      }
+      auto it = _index.emplace(k, hash, std::move(v));
+      _grown();
+      if (_budget) _account(it, hash);
+    }
+    p.groups.reset();
+    p.rows->rewind();
+    for (size_t i = 0; i < p.rows->count(); ++i) {
+      ktype k;
+      vtype v;
+      p.rows->read(k, v);
+      kref kr{k};
+      auto hash = _index.hash(kr);
+      auto &sub = _parts[_part(hash)];
+      if (sub.rows) {
+        sub.rows->write(k, v);
+        continue;
+      }
+      _fold(kr, vref{v}, hash);
+    }
+    p.rows.reset();
+  }
+
+  // the spilled partitions are reduced one after the other, with the
+  // partitions of each that are spilled again reduced right after it
+  void _drain() {
+    if (_nSpilled == 0) return;
+    auto parts = std::move(_parts);
+    for (auto &it : _parts) it = Part{};
+    _nSpilled = 0;
+    _bytes = 0;
+    ++_level;
+    for (auto &it : parts) {
+      if (!it.rows) continue;
+      _unspill(it);
+      callEm<FO>();
+      _index.clear();
+      _bytes = 0;
+      for (auto &jt : _parts) jt.bytes = 0;
+      _drain();
+    }
+    --_level;
+  }
+
   virtual void _dataEnd(int) final override {
     if(!_scan) callEm<FO>();
-    _first = true;
     _index.clear();
+    _bypass = false;
+    _nWindow = _nNew = 0;
+    _drain();
+    _bytes = 0;
+    for (auto &it : _parts) it.bytes = 0;
   }
 
   template <class T>
@@ -139,20 +348,20 @@ private:
     }
   }
 
-  template <class T>
-  auto callKey(typename maptype::iterator it, typename std::enable_if<!meta::isVector<T>{}>::type* dummy = 0) {
-    auto x = meta::slctTupleRef(meta::tieTup(it->first, it->second), Oslct{});
+  template <class T, class K, class R>
+  auto callKey(const K &key, const R &val, typename std::enable_if<!meta::isVector<T>{}>::type* dummy = 0) {
+    auto x = meta::slctTupleRef(meta::tieTup(key, val), Oslct{});
     for (auto &jt : Link<itype, otype>::next()) {
       jt.second->dataEvent(x);
     }
   }
 
-  template <class T>
-  auto callKey(typename maptype::iterator it, typename std::enable_if<meta::isVector<T>{}>::type* dummy = 0) {
+  template <class T, class K, class R>
+  auto callKey(const K &key, const R &val, typename std::enable_if<meta::isVector<T>{}>::type* dummy = 0) {
     std::vector<otype> res;
-    res.reserve(it->second.size());
-    for(const auto& jt : it->second) {
-      res.push_back(meta::slctTupleRef(meta::tieTup(it->first, jt), Oslct{}));
+    res.reserve(val.size());
+    for(const auto& jt : val) {
+      res.push_back(meta::slctTupleRef(meta::tieTup(key, jt), Oslct{}));
     }
     for (auto &jt : Link<itype, otype>::next()) {
       jt.second->dataEvent(res);
@@ -166,10 +375,17 @@ private:
   bool _scan{false};
   const bool _ordered{false};
   maptype _index;
-  HashScheme _hash{};
   EqWrapper _eq;
-  bool _first{true};
-  typename maptype::iterator _preIt;
+  size_t _budget;
+  size_t _bytes{0};
+  size_t _nSpilled{0};
+  std::array<Part, nParts> _parts;
+  size_t _level{0};
+  const bool _partial{false};
+  bool _bypass{false};
+  size_t _nWindow{0};
+  size_t _nNew{0};
+  size_t *_peak;
 };
 }
 } // namespace ezl ezl::detail
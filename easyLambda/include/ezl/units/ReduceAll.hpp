@@ -15,9 +15,10 @@
 #include <tuple>
 #include <vector>
 
-#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <ezl/pipeline/Link.hpp>
+#include <ezl/helper/FlatMap.hpp>
 #include <ezl/helper/meta/coherentVector.hpp>
 #include <ezl/helper/meta/slctTuple.hpp>
 #include <ezl/helper/meta/typeInfo.hpp>
@@ -31,6 +32,8 @@ namespace detail {
  * 
  * The UDF can have params of type: tuple of key columns followed by vector of
  * tupleof value columns or key columns followed by vectors of value columns.
+ * An `ezl::Window` can be taken in place of a vector, with adjacent its rows
+ * slide in amortized constant time rather than moving all the rows each time.
  *
  * Key and value columns can be selected by indices. 
  *
@@ -60,7 +63,7 @@ public:
   using buftype = typename TypeInfo::buftype;
   using otype = typename TypeInfo::otype;
   using HashScheme = boost::hash<kref>;
-  using maptype = boost::unordered_map<ktype, buftype>;
+  using maptype = FlatMap<ktype, buftype, HashScheme, EqWrapper>;
 
   static constexpr int osize = std::tuple_size<otype>::value;
 
@@ -71,16 +74,22 @@ public:
   virtual void dataEvent(const itype &data) final override {
     kref curKey = meta::slctTupleRef(data, _kslct);
     auto curVal = meta::slctTuple(data, _vslct);
-    auto it = _index.find(curKey, _hash, _eq);
+    // in ordered mode only the current group is in the table, it is reduced
+    // and erased when a row of another group arrives
+    if (_ordered && !_index.empty() && !_eq(std::begin(_index)->first, curKey)) {
+      _processReduceAll(std::begin(_index)->first, std::begin(_index)->second);
+      _index.erase(std::begin(_index));
+    }
+    auto hash = _index.hash(curKey);
+    auto it = _index.find(curKey, hash);
     if (it == std::end(_index)) {
       buftype v;
       meta::coherentPush(v, curVal);
-      it = _index.emplace_hint(it, ktype(curKey), v);
+      it = _index.emplace(curKey, hash, std::move(v));
     } else {
       meta::coherentPush(it->second, curVal);
     }
     if (_bunchSize > 0) { _processBunched(it); }
-    if (_ordered) { _processOrdered(it); }
   } 
 
 private:
@@ -97,7 +106,6 @@ private:
       }
     }
     _index.clear();
-    _first = false;
   }
 
   void _processReduceAll(const ktype &key, const buftype &buffer) {
@@ -134,7 +142,7 @@ private:
     if (size >= _bunchSize) {
       _processReduceAll(it->first, it->second);
       if (_adjacent) {
-        meta::coherentPopFront(it->second); // TODO: optimize pop
+        meta::coherentPopFront(it->second);
       } else {
         meta::coherentClear(it->second);
       }
@@ -143,17 +151,6 @@ private:
     return false;
   }
 
-  void _processOrdered(const typename maptype::iterator& it) {
-    if (_first) {
-      _first = false;
-      _preIt = it;
-    } else if (_preIt->first != it->first) {
-      _processReduceAll(_preIt->first, _preIt->second);
-      _index.erase(_preIt);
-      _preIt = it;
-    }
-  }
-
 private:
   Func _func;
   bool _ordered{false};
@@ -161,10 +158,7 @@ private:
   int _bunchSize{0};
   bool _fixed{false};
   maptype _index;
-  HashScheme _hash;
   EqWrapper _eq;
-  bool _first{true};
-  typename maptype::iterator _preIt;
   typename TypeInfo::Kslct _kslct;
   typename TypeInfo::Vslct _vslct;
   typename TypeInfo::Oslct _oslct;
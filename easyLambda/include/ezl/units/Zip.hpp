@@ -15,8 +15,9 @@
 #include <deque>
 #include <tuple>
 
-#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
 
+#include <ezl/helper/FlatMap.hpp>
 #include <ezl/pipeline/Source.hpp>
 #include <ezl/pipeline/Dest.hpp>
 #include <ezl/helper/meta/slctTuple.hpp>
@@ -51,9 +52,9 @@ public:
   using kref = typename meta::SlctTupleRefType<I1, Kslct1>::type;
   using v1type = std::deque<typename meta::SlctTupleType<I1>::type>;
   using v2type = std::deque<typename meta::SlctTupleType<I2>::type>;
-  using maptype1 =  boost::unordered_map<ktype, v1type>;
-  using maptype2 =  boost::unordered_map<ktype, v2type>;
   using HashScheme = boost::hash<kref>;
+  using maptype1 = FlatMap<ktype, v1type, HashScheme, EqWrapper>;
+  using maptype2 = FlatMap<ktype, v2type, HashScheme, EqWrapper>;
 
   using Dest<I1>::dataEvent;
   using Dest<I2>::dataEvent;
@@ -64,27 +65,29 @@ public:
 
   virtual void dataEvent(const I1 &data) final override {
     kref curKey = meta::slctTupleRef(data, Kslct1{});
-    auto it = _index1.find(curKey, _hash, _eq);
+    auto hash = _index1.hash(curKey);
+    auto it = _index1.find(curKey, hash);
     if (it != std::end(_index1)) {
       it->second.push_back(data); 
     } else {
       v1type v {data};
-      it = _index1.emplace_hint(it, ktype(curKey), v); 
+      it = _index1.emplace(curKey, hash, std::move(v)); 
     } 
-    auto it2 = _index2.find(curKey, _hash, _eq);
+    auto it2 = _index2.find(curKey, hash);
     if (it2 != std::end(_index2)) _flush(it, it2);
   }
 
   virtual void dataEvent(const I2 &data) final override {
     kref curKey = meta::slctTupleRef(data, Kslct2{});
-    auto it = _index2.find(curKey, _hash, _eq);
+    auto hash = _index2.hash(curKey);
+    auto it = _index2.find(curKey, hash);
     if (it != std::end(_index2)) {
       it->second.push_back(data); 
     } else {
       v2type v {data};
-      it = _index2.emplace_hint(it, ktype(curKey), v); 
+      it = _index2.emplace(curKey, hash, std::move(v)); 
     } 
-    auto it1 = _index1.find(curKey, _hash, _eq);
+    auto it1 = _index1.find(curKey, hash);
     if (it1 != std::end(_index1)) _flush(it1, it);
   }
 
@@ -179,15 +182,8 @@ public:
 
 private:
   void _dataEnd(int) {
-    for (auto it = _index1.begin(); it != _index1.end();) {
-      auto it2 = _index2.find(it->first, _hash, _eq);
-      if (it2 != std::end(_index2)) {
-        _flush(it, it2);
-        _index2.erase(it2);
-      }
-      it = _index1.erase(it);
-    }
-    //auto it1 = _index1.find(curKey, _hash, _eq);
+    // a key is never left in both the tables since the rows are flushed as
+    // soon as both the sides have one
     _index1.clear();
     _index2.clear();
   }
@@ -213,8 +209,6 @@ private:
 
   maptype1 _index1;
   maptype2 _index2;
-  EqWrapper _eq;
-  HashScheme _hash;
   bool _visited{false};
   bool _traversingRoots{false};
   bool _traversingTasks{false};
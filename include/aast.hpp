@@ -9,16 +9,25 @@
 
 #include <boost/config/warning_disable.hpp>
 #include <boost/variant/recursive_variant.hpp>
+#include <boost/variant/get.hpp>
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <boost/fusion/include/io.hpp>
 #include <boost/optional.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include <helper.hpp>
+#include <plugin.hpp>
+#include <sketch.hpp>
 
 namespace client { namespace reduce { namespace ast
 {
@@ -28,7 +37,11 @@ namespace client { namespace reduce { namespace ast
     enum class optoken : int {
       sum,
       max,
-      count
+      count,
+      min,
+      avg,
+      var,
+      stddev
     };
 
     typedef boost::variant<variable , column> operand;
@@ -38,7 +51,45 @@ namespace client { namespace reduce { namespace ast
       operand operand_;
     };
 
-    using expr = std::list<operation>;
+    // aggregate from a shared library, cmd "lib.so" agg($x)
+    struct udf {
+      std::string path;
+      std::string fn;
+      operand operand_;
+    };
+
+    // approx_distinct(%x) or approx_distinct($x), a HyperLogLog sketch
+    struct approx {
+      bool isStr;
+      operand operand_;
+    };
+
+    // quantile($x, 0.5, 0.99), a t-digest that gives a column for each
+    struct quantile {
+      operand operand_;
+      std::vector<double> qs;
+    };
+
+    // hist($x, 10, 0, 100) counts in 10 bins of equal width over [0, 100) and
+    // hist($x, 10) in 10 bins that adapt to the values, giving the center of each
+    struct hist {
+      operand operand_;
+      unsigned int bins;
+      std::vector<double> range;
+    };
+
+    using aggregate = boost::variant<operation, udf, approx, quantile, hist>;
+
+    // name of the column of a quantile, p50 or p99_9
+    inline std::string quantileName(double q) {
+      auto s = std::to_string(q * 100);
+      s.erase(s.find_last_not_of('0') + 1);
+      if (s.back() == '.') s.pop_back();
+      std::replace(begin(s), end(s), '.', '_');
+      return "p" + s;
+    }
+
+    using expr = std::list<aggregate>;
 
     // print functions for debugging
     struct printer {
@@ -51,6 +102,10 @@ namespace client { namespace reduce { namespace ast
                 case optoken::sum: std::cout << " sum"; break;
                 case optoken::max: std::cout << " max"; break;
                 case optoken::count: std::cout << " count"; break;
+                case optoken::min: std::cout << " min"; break;
+                case optoken::avg: std::cout << " avg"; break;
+                case optoken::var: std::cout << " var"; break;
+                case optoken::stddev: std::cout << " stddev"; break;
             }
         }
         
@@ -59,9 +114,77 @@ namespace client { namespace reduce { namespace ast
           boost::apply_visitor(*this, x.operand_);
         }
 
+        void operator()(udf const &x) const {
+          std::cout << " cmd \"" << x.path << "\" " << x.fn;
+          boost::apply_visitor(*this, x.operand_);
+        }
+
+        void operator()(approx const &x) const {
+          std::cout << " approx_distinct" << (x.isStr ? " string" : "");
+          boost::apply_visitor(*this, x.operand_);
+        }
+
+        void operator()(quantile const &x) const {
+          std::cout << " quantile";
+          boost::apply_visitor(*this, x.operand_);
+          for (auto q : x.qs) std::cout << ' ' << q;
+        }
+
+        void operator()(hist const &x) const {
+          std::cout << " hist";
+          boost::apply_visitor(*this, x.operand_);
+          std::cout << ' ' << x.bins;
+          for (auto r : x.range) std::cout << ' ' << r;
+        }
+
         void operator()(expr const& x) const {
-          for (auto&it : x) (*this)(it);
+          for (auto&it : x) boost::apply_visitor(*this, it);
+        }
+    };
+
+    // variables and columns the aggregates refer to
+    struct depsEval {
+    private:
+      using ColIndices = client::helper::ColIndices;
+    public:
+      using result_type = ColIndices;
+      result_type operator()(variable const &x) const {
+        ColIndices res;
+        res.var.push_back(x);
+        return res;
+      }
+      result_type operator()(column const &x) const {
+        ColIndices res;
+        res.num.push_back(x);
+        return res;
+      }
+      result_type operator()(operation const& x) const {
+        return boost::apply_visitor(*this, x.operand_);
+      }
+      result_type operator()(udf const& x) const {
+        return boost::apply_visitor(*this, x.operand_);
+      }
+      result_type operator()(approx const& x) const {
+        auto res = boost::apply_visitor(*this, x.operand_);
+        if (x.isStr) {
+          res.str = std::move(res.num);
+          res.varStr = std::move(res.var);
+          res.num.clear();
+          res.var.clear();
         }
+        return res;
+      }
+      result_type operator()(quantile const& x) const {
+        return boost::apply_visitor(*this, x.operand_);
+      }
+      result_type operator()(hist const& x) const {
+        return boost::apply_visitor(*this, x.operand_);
+      }
+      result_type operator()(expr const& e) const {
+        result_type res{};
+        for (const auto& oper : e) res.add(boost::apply_visitor(*this, oper));
+        return res;
+      }
     };
 
     struct colsEval {
@@ -95,15 +218,70 @@ namespace client { namespace reduce { namespace ast
       result_type operator()(operation const& x) {
           switch (x.operator_) {
               case optoken::sum: _nm = std::string{"sum"}; break;
-              case optoken::max: _nm = std::string{"max"};
-              case optoken::count: _nm = std::string{"count"};
+              case optoken::max: _nm = std::string{"max"}; break;
+              case optoken::count: _nm = std::string{"count"}; break;
+              case optoken::min: _nm = std::string{"min"}; break;
+              case optoken::avg: _nm = std::string{"avg"}; break;
+              case optoken::var: _nm = std::string{"var"}; break;
+              case optoken::stddev: _nm = std::string{"stddev"}; break;
           }
           return boost::apply_visitor(*this, x.operand_);
       }
+      result_type operator()(udf const& x) {
+          auto err = client::plugin::check(x.path, {x.fn + "_size", x.fn + "_init", x.fn + "_update",
+                                                    x.fn + "_merge", x.fn + "_final"});
+          if (err.size() > 0) return std::make_pair(ColIndices{}, err);
+          _nm = x.fn;
+          return boost::apply_visitor(*this, x.operand_);
+      }
+      // a string column is checked by the cols evaluator of the query
+      result_type operator()(approx const& x) {
+          _nm = "approx_distinct";
+          if (!x.isStr) return boost::apply_visitor(*this, x.operand_);
+          ColIndices res;
+          auto c = boost::get<column>(&x.operand_);
+          if (!c) res.var.push_back(_nm + "_" + boost::get<variable>(x.operand_));
+          else if (*c <= _headers.size()) res.var.push_back(_nm + "_" + _headers[*c - 1]);
+          else res.var.push_back(_nm + "_" + std::to_string(*c));
+          return std::make_pair(res, "");
+      }
+      result_type operator()(quantile const& x) {
+          result_type res{};
+          for (auto q : x.qs) {
+            if (q < 0 || q > 1) return std::make_pair(ColIndices{}, "Error: quantile " + std::to_string(q) + " is not in [0, 1].");
+            _nm = quantileName(q);
+            auto y = boost::apply_visitor(*this, x.operand_);
+            if (y.second.size() > 0) return y;
+            res.first.add(y.first);
+          }
+          return res;
+      }
+      // hist0, hist1.. for the counts and bin0, bin1.. for the adaptive centers
+      result_type operator()(hist const& x) {
+          if (x.bins == 0) return std::make_pair(ColIndices{}, "Error: hist needs at least one bin.");
+          if (x.range.size() != 0 && x.range.size() != 2) {
+            return std::make_pair(ColIndices{}, "Error: hist takes the bins and optionally the least and the greatest value.");
+          }
+          if (x.range.size() == 2 && !(x.range[0] < x.range[1])) {
+            return std::make_pair(ColIndices{}, "Error: hist range " + std::to_string(x.range[0]) + " to " + std::to_string(x.range[1]) + " is empty.");
+          }
+          result_type res{};
+          for (unsigned int i = 0; i < x.bins; ++i) {
+            std::vector<std::string> nms{"hist" + std::to_string(i)};
+            if (x.range.empty()) nms.insert(begin(nms), "bin" + std::to_string(i));
+            for (const auto &nm : nms) {
+              _nm = nm;
+              auto y = boost::apply_visitor(*this, x.operand_);
+              if (y.second.size() > 0) return y;
+              res.first.add(y.first);
+            }
+          }
+          return res;
+      }
       result_type operator()(expr const& e) {
           result_type res{};
           for (const auto& oper : e) {
-            auto x = (*this)(oper);
+            auto x = boost::apply_visitor(*this, oper);
             if (x.second.size() > 0) return x;
             res.first.add(x.first);
           }
@@ -111,8 +289,48 @@ namespace client { namespace reduce { namespace ast
       }
   };
 
+    // string columns that approx_distinct counts, prior to the reduce the rows
+    // get a numeric column with the hll code of each, named by codeName
+    inline std::string codeName(operand const& x) {
+      if (auto v = boost::get<variable>(&x)) return "%" + *v;
+      return "%" + std::to_string(boost::get<column>(x));
+    }
+
+    inline std::vector<operand> strOperands(expr const& x) {
+      std::vector<operand> res;
+      for (const auto& oper : x) {
+        auto a = boost::get<approx>(&oper);
+        if (!a || !a->isStr) continue;
+        if (std::find(begin(res), end(res), a->operand_) == end(res)) res.push_back(a->operand_);
+      }
+      return res;
+    }
+
+    // entry points of an aggregate from a shared library
+    struct udfFns {
+      pawnAggSizeFn *size;
+      pawnAggInitFn *init;
+      pawnAggUpdateFn *update;
+      pawnAggMergeFn *merge;
+      pawnAggFinalFn *final;
+      udfFns(udf const& x)
+          : size{client::plugin::symbol<pawnAggSizeFn>(x.path, x.fn + "_size")},
+            init{client::plugin::symbol<pawnAggInitFn>(x.path, x.fn + "_init")},
+            update{client::plugin::symbol<pawnAggUpdateFn>(x.path, x.fn + "_update")},
+            merge{client::plugin::symbol<pawnAggMergeFn>(x.path, x.fn + "_merge")},
+            final{client::plugin::symbol<pawnAggFinalFn>(x.path, x.fn + "_final")} {}
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     //  The AST evaluator
+    //  The result row is the state of the aggregates, a double each for sum,
+    //  max, min and count, the count and the sum for avg, the count, mean and
+    //  sum of squared deviations for var and stddev, the packed registers of
+    //  a HyperLogLog for approx_distinct, a t-digest for quantile, the bins of
+    //  hist and `size` for an aggregate from a shared library. The partial
+    //  reduce updates the state with the rows and the final one (sameIndex)
+    //  merges the partial states, `finalize` turns the state into a value per
+    //  aggregate.
     ///////////////////////////////////////////////////////////////////////////
     struct evaluator {
     private:
@@ -131,36 +349,223 @@ namespace client { namespace reduce { namespace ast
 
         const indexHelper _index;
         bool _sameIndex {false};
+
+        static size_t width(aggregate const& x) {
+          if (auto u = boost::get<udf>(&x)) return udfFns{*u}.size();
+          if (boost::get<approx>(&x)) return sketch::hll::width;
+          if (boost::get<quantile>(&x)) return sketch::tdigest::width;
+          if (auto h = boost::get<hist>(&x)) return h->range.empty() ? sketch::hist::width(h->bins) : h->bins;
+          switch (boost::get<operation>(x).operator_) {
+            case optoken::avg: return 2;
+            case optoken::var: case optoken::stddev: return 3;
+            default: return 1;
+          }
+        }
     public:
         using resT = std::tuple<std::vector<double>>&;
         using keyT = const std::vector<std::string>&;
         using rowT = const std::vector<double>&;
         using retFnT = std::function<resT(resT, keyT, rowT)>;
+        using finalFnT = std::function<std::vector<double>(const std::vector<double>&)>;
         typedef retFnT result_type;
         void sameIndex(bool isSameIndex = true) { _sameIndex = isSameIndex; }
 
         evaluator(helper::positionTeller p) : _index{p} {}
 
-        retFnT operator()(operation const& x, int i) const {
-            int j = _sameIndex ? i : boost::apply_visitor(_index, x.operand_);
-            switch (x.operator_)
-            {
-                case optoken::sum: return [i, j](resT r, keyT, rowT c) -> auto& { std::get<0>(r)[i] += c[j]; return r; };
-                case optoken::max: return [i, j](resT r, keyT, rowT c) -> auto& { if (c[j] > std::get<0>(r)[i]) std::get<0>(r)[i] = c[j]; return r; };
-                case optoken::count: return [i, j](resT r, keyT, rowT c) -> auto& { std::get<0>(r)[i] += 1.0; return r; };
+        // the row is passed as a batch of one with the keys and the operand
+        retFnT operator()(udf const& x, int i) const {
+            udfFns f{x};
+            if (_sameIndex) {
+                auto merge = f.merge;
+                return [i, merge](resT r, keyT, rowT c) -> auto& { merge(std::get<0>(r).data() + i, c.data() + i); return r; };
             }
-            return [i, j](resT r, keyT, rowT c) -> auto& { if (c[j] > std::get<0>(r)[i]) std::get<0>(r)[i] = c[j]; return r; };
+            int j = boost::apply_visitor(_index, x.operand_);
+            auto update = f.update;
+            auto str = std::make_shared<std::vector<const char *>>();
+            auto len = std::make_shared<std::vector<size_t>>();
+            return [i, j, update, str, len](resT r, keyT k, rowT c) -> auto& {
+                str->resize(k.size());
+                len->resize(k.size());
+                for (size_t s = 0; s < k.size(); ++s) {
+                    (*str)[s] = k[s].data();
+                    (*len)[s] = k[s].size();
+                }
+                pawnBatch b{1, k.size(), 1, str->data(), len->data(), &c[j]};
+                update(std::get<0>(r).data() + i, &b);
+                return r;
+            };
         }
 
-        std::vector<retFnT> operator()(expr const& x) const {
-            std::vector<retFnT> v;
+        // the aggregates fused in a single routine, the builtins are grouped
+        // by the operator into tight loops over (state, column) pairs and a
+        // count reads no column. The final reduce adds up the partial counts,
+        // an avg is a count and a sum. var and stddev update the mean and the
+        // squared deviations with Welford's method and merge them with Chan's.
+        retFnT operator()(expr const& x) const {
+            std::vector<std::pair<int, int>> sums, maxs, mins, moments, distincts, codes, digests;
+            std::vector<std::tuple<int, int, hist>> hists;
+            std::vector<int> counts;
+            std::vector<retFnT> udfs;
             int i = 0;
             for (const auto& oper : x) {
-                v.push_back((*this)(oper, i++));
+                if (auto u = boost::get<udf>(&oper)) {
+                    udfs.push_back((*this)(*u, i));
+                } else if (auto a = boost::get<approx>(&oper)) {
+                    if (_sameIndex) distincts.emplace_back(i, i);
+                    else if (a->isStr) codes.emplace_back(i, _index(codeName(a->operand_)));
+                    else distincts.emplace_back(i, boost::apply_visitor(_index, a->operand_));
+                } else if (auto q = boost::get<quantile>(&oper)) {
+                    digests.emplace_back(i, _sameIndex ? i : boost::apply_visitor(_index, q->operand_));
+                } else if (auto h = boost::get<hist>(&oper)) {
+                    hists.emplace_back(i, _sameIndex ? i : boost::apply_visitor(_index, h->operand_), *h);
+                } else {
+                    const auto &o = boost::get<operation>(oper);
+                    int j = _sameIndex ? i : boost::apply_visitor(_index, o.operand_);
+                    switch (o.operator_) {
+                        case optoken::sum: sums.emplace_back(i, j); break;
+                        case optoken::max: maxs.emplace_back(i, j); break;
+                        case optoken::min: mins.emplace_back(i, j); break;
+                        case optoken::count:
+                            if (_sameIndex) sums.emplace_back(i, j);
+                            else counts.push_back(i);
+                            break;
+                        case optoken::avg:
+                            if (_sameIndex) sums.emplace_back(i, i);
+                            else counts.push_back(i);
+                            sums.emplace_back(i + 1, _sameIndex ? i + 1 : j);
+                            break;
+                        case optoken::var: case optoken::stddev:
+                            moments.emplace_back(i, j);
+                            break;
+                    }
+                }
+                i += width(oper);
+            }
+            auto isMerge = _sameIndex;
+            return [sums, maxs, mins, moments, distincts, codes, digests, hists, counts, udfs, isMerge](resT r, keyT k, rowT c) -> auto& {
+                auto &s = std::get<0>(r);
+                for (const auto &it : sums) s[it.first] += c[it.second];
+                for (const auto &it : maxs) if (c[it.second] > s[it.first]) s[it.first] = c[it.second];
+                for (const auto &it : mins) if (c[it.second] < s[it.first]) s[it.first] = c[it.second];
+                for (auto it : counts) s[it] += 1.0;
+                for (const auto &it : moments) {
+                    auto m = &s[it.first];
+                    if (isMerge) {
+                        auto o = &c[it.second];
+                        auto n = m[0] + o[0];
+                        if (o[0] == 0.0) continue;
+                        auto delta = o[1] - m[1];
+                        m[1] += delta * o[0] / n;
+                        m[2] += o[2] + delta * delta * m[0] * o[0] / n;
+                        m[0] = n;
+                    } else {
+                        auto delta = c[it.second] - m[1];
+                        m[0] += 1.0;
+                        m[1] += delta / m[0];
+                        m[2] += delta * (c[it.second] - m[1]);
+                    }
+                }
+                for (const auto &it : distincts) {
+                    if (isMerge) sketch::hll::merge(&s[it.first], &c[it.second]);
+                    else sketch::hll::add(&s[it.first], sketch::hll::code(sketch::hash(c[it.second])));
+                }
+                for (const auto &it : codes) sketch::hll::add(&s[it.first], c[it.second]);
+                for (const auto &it : digests) {
+                    if (isMerge) sketch::tdigest::merge(&s[it.first], &c[it.second]);
+                    else sketch::tdigest::add(&s[it.first], c[it.second]);
+                }
+                for (const auto &it : hists) {
+                    auto m = &s[std::get<0>(it)];
+                    auto o = &c[std::get<1>(it)];
+                    const auto &h = std::get<2>(it);
+                    if (isMerge && h.range.empty()) {
+                        sketch::hist::merge(m, o, h.bins);
+                    } else if (isMerge) {
+                        for (unsigned int b = 0; b < h.bins; ++b) m[b] += o[b];
+                    } else if (std::isnan(*o)) {
+                        continue;
+                    } else if (h.range.empty()) {
+                        sketch::hist::add(m, h.bins, *o);
+                    } else {
+                        sketch::hist::add(m, h.bins, h.range[0], h.range[1], *o);
+                    }
+                }
+                for (const auto &f : udfs) f(r, k, c);
+                return r;
+            };
+        }
+
+        // state of a group prior to any row
+        std::vector<double> initial(expr const& x) const {
+            std::vector<double> res;
+            for (const auto& oper : x) {
+                auto i = res.size();
+                res.resize(i + width(oper));
+                auto o = boost::get<operation>(&oper);
+                if (auto u = boost::get<udf>(&oper)) {
+                    udfFns{*u}.init(res.data() + i);
+                } else if (o && o->operator_ == optoken::max) {
+                    res[i] = -std::numeric_limits<double>::infinity();
+                } else if (o && o->operator_ == optoken::min) {
+                    res[i] = std::numeric_limits<double>::infinity();
+                }
             }
-            return v;
+            return res;
         }
 
+        // empty if the state of every aggregate is its value
+        finalFnT finalize(expr const& x) const {
+            using outT = std::function<double(const double *)>;
+            std::vector<std::pair<size_t, outT>> outs;
+            bool isSame = true;
+            size_t i = 0;
+            for (const auto& oper : x) {
+                outT f = [](const double *s) { return s[0]; };
+                if (auto q = boost::get<quantile>(&oper)) {
+                    for (auto p : q->qs) {
+                        outs.emplace_back(i, [p](const double *s) { return sketch::tdigest::quantile(s, p); });
+                    }
+                    isSame = false;
+                    i += width(oper);
+                    continue;
+                }
+                if (auto h = boost::get<hist>(&oper)) {
+                    for (size_t b = 0; b < h->bins; ++b) {
+                        if (h->range.empty()) {
+                            outs.emplace_back(i, [b](const double *s) { return sketch::hist::center(s, b); });
+                            outs.emplace_back(i, [b](const double *s) { return sketch::hist::count(s, b); });
+                        } else {
+                            outs.emplace_back(i + b, f);
+                        }
+                    }
+                    isSame = false;
+                    i += width(oper);
+                    continue;
+                }
+                if (auto u = boost::get<udf>(&oper)) {
+                    f = udfFns{*u}.final;
+                } else if (boost::get<approx>(&oper)) {
+                    f = sketch::hll::estimate;
+                } else {
+                    switch (boost::get<operation>(oper).operator_) {
+                        case optoken::avg: f = [](const double *s) { return s[1] / s[0]; }; break;
+                        case optoken::var: f = [](const double *s) { return s[0] > 1 ? s[2] / (s[0] - 1) : 0.0; }; break;
+                        case optoken::stddev: f = [](const double *s) { return s[0] > 1 ? std::sqrt(s[2] / (s[0] - 1)) : 0.0; }; break;
+                        default: break;
+                    }
+                }
+                isSame = isSame && width(oper) == 1 && !boost::get<udf>(&oper);
+                outs.emplace_back(i, std::move(f));
+                i += width(oper);
+            }
+            if (isSame) return finalFnT{};
+            return [outs](const std::vector<double> &state) {
+                std::vector<double> res;
+                res.reserve(outs.size());
+                for (const auto &it : outs) res.push_back(it.second(state.data() + it.first));
+                return res;
+            };
+        }
     };
 }}}
 
@@ -169,4 +574,30 @@ BOOST_FUSION_ADAPT_STRUCT(
     (client::reduce::ast::optoken, operator_)
     (client::reduce::ast::operand, operand_)
 )
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::reduce::ast::quantile,
+    (client::reduce::ast::operand, operand_)
+    (std::vector<double>, qs)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::reduce::ast::hist,
+    (client::reduce::ast::operand, operand_)
+    (unsigned int, bins)
+    (std::vector<double>, range)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::reduce::ast::approx,
+    (bool, isStr)
+    (client::reduce::ast::operand, operand_)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::reduce::ast::udf,
+    (std::string, path)
+    (std::string, fn)
+    (client::reduce::ast::operand, operand_)
+)
 #endif
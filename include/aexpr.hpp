@@ -21,6 +21,11 @@ namespace client { namespace reduce { namespace parser {
 
         qi::rule<Iterator, ast::expr(), ascii::space_type> expr;
         qi::rule<Iterator, ast::operation(), ascii::space_type> operation;
+        qi::rule<Iterator, ast::udf(), ascii::space_type> udf;
+        qi::rule<Iterator, ast::approx(), ascii::space_type> approx;
+        qi::rule<Iterator, ast::quantile(), ascii::space_type> quantile;
+        qi::rule<Iterator, ast::hist(), ascii::space_type> hist;
+        qi::rule<Iterator, std::string(), ascii::space_type> quoted, name;
         qi::rule<Iterator, ast::operand(), ascii::space_type> operand;
         qi::rule<Iterator, std::string(), ascii::space_type> identifier;
         qi::rule<Iterator, unsigned int, ascii::space_type> colIndex;
@@ -22,6 +22,8 @@ namespace client { namespace reduce { namespace parser
         qi::alnum_type alnum;
         qi::bool_type bool_;
         qi::double_type double_;
+        qi::attr_type attr;
+        qi::lit_type lit;
 
         using qi::on_error;
         using qi::on_success;
@@ -34,14 +36,32 @@ namespace client { namespace reduce { namespace parser
             ("sum", ast::optoken::sum)
             ("max", ast::optoken::max)
             ("count", ast::optoken::count)
+            ("min", ast::optoken::min)
+            ("avg", ast::optoken::avg)
+            ("var", ast::optoken::var)
+            ("stddev", ast::optoken::stddev)
             ;
 
         ///////////////////////////////////////////////////////////////////////
         // Main expression grammar
-        expr = +(operation);
+        expr = +(operation | udf | approx | quantile | hist);
 
         operation = op >> operand;
 
+        udf = "cmd" >> quoted >> name >> operand;
+
+        approx = lit("approx_distinct") >> '('
+            >> ((lit('%') >> attr(true)) | (lit('$') >> attr(false)))
+            >> (name | uint_) >> ')';
+
+        quantile = lit("quantile") >> '(' >> (identifier | colIndex) >> +(',' >> double_) >> ')';
+
+        hist = lit("hist") >> '(' >> (identifier | colIndex) >> ',' >> uint_ >> *(',' >> double_) >> ')';
+
+        quoted = '"' >> raw[lexeme[*(char_ - '"')]] >> '"';
+
+        name = raw[lexeme[(alpha | '_') >> *(alnum | '_')]];
+
         operand = '(' >> (identifier |   colIndex) >> ')';
 
         identifier = '$' >> raw[lexeme[(alpha | '_') >> *(alnum | '_')]];
@@ -52,6 +72,10 @@ namespace client { namespace reduce { namespace parser
         BOOST_SPIRIT_DEBUG_NODES(
             (expr)
             (operand)
+            (udf)
+            (approx)
+            (quantile)
+            (hist)
             (identifier)
             (colIndex)
         );
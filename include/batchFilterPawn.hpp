@@ -0,0 +1,114 @@
+/*!
+ * @file
+ * class BatchFilterPawn, unit for a filter from a batch ABI library.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef BATCHFILTERPAWN_EZL_H
+#define BATCHFILTERPAWN_EZL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <ezl/pipeline/Link.hpp>
+
+#include <pawn_plugin.h>
+
+namespace ezl {
+
+/*!
+ * @ingroup units
+ * Keeps the rows in a batch of fixed size and calls the filter of the
+ * library once for the batch when it is full and at the end of data. The
+ * string columns of the batch point into the kept rows and the numeric
+ * columns are written column major as each row comes in. The rows that the
+ * filter keeps are passed on as they are kept, the buffers of the batch are
+ * reused from one to the next.
+ * */
+class BatchFilterPawn
+    : public Link<std::tuple<const std::vector<std::string>&, const std::vector<double>&>,
+                  std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+
+  BatchFilterPawn(pawnFilterFn *fn, size_t rows) : _fn{fn}, _cap{std::max(rows, size_t(1))} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    const auto &s = std::get<0>(data);
+    const auto &v = std::get<1>(data);
+    if (_n == 0) _reserve(s.size(), v.size());
+    _s[_n].assign(std::begin(s), std::end(s));
+    _v[_n].assign(std::begin(v), std::end(v));
+    for (size_t c = 0; c < _nStr; ++c) {
+      _str[c * _cap + _n] = _s[_n][c].data();
+      _len[c * _cap + _n] = _s[_n][c].size();
+    }
+    for (size_t c = 0; c < _nNum; ++c) _num[c * _cap + _n] = v[c];
+    if (++_n == _cap) _flush();
+  }
+
+private:
+  void _reserve(size_t nStr, size_t nNum) {
+    _nStr = nStr;
+    _nNum = nNum;
+    _s.resize(_cap);
+    _v.resize(_cap);
+    _str.resize(_cap * _nStr);
+    _len.resize(_cap * _nStr);
+    _num.resize(_cap * _nNum);
+  }
+
+  // a short batch is packed to its own number of rows per column
+  template <class T> void _pack(std::vector<T> &col, size_t cols) {
+    for (size_t c = 1; c < cols; ++c) {
+      std::copy_n(std::begin(col) + c * _cap, _n, std::begin(col) + c * _n);
+    }
+  }
+
+  void _flush() {
+    if (_n == 0) return;
+    if (_n < _cap) {
+      _pack(_str, _nStr);
+      _pack(_len, _nStr);
+      _pack(_num, _nNum);
+    }
+    _sel.assign((_n + 63) / 64, 0);
+    pawnBatch b{_n, _nStr, _nNum, _str.data(), _len.data(), _num.data()};
+    _fn(&b, _sel.data());
+    auto n = _n;
+    _n = 0;
+    for (size_t r = 0; r < n; ++r) {
+      if (!((_sel[r / 64] >> (r % 64)) & 1)) continue;
+      rowT res{_s[r], _v[r]};
+      for (auto &it : this->next()) {
+        it.second->dataEvent(res);
+      }
+    }
+  }
+
+  virtual void _dataEnd(int) override final { _flush(); }
+
+  pawnFilterFn *_fn;
+  size_t _cap;
+  size_t _n{0};
+  size_t _nStr{0};
+  size_t _nNum{0};
+  std::vector<std::vector<std::string>> _s;
+  std::vector<std::vector<double>> _v;
+  std::vector<const char *> _str;
+  std::vector<size_t> _len;
+  std::vector<double> _num;
+  std::vector<uint64_t> _sel;
+};
+} // namespace ezl
+
+#endif // !BATCHFILTERPAWN_EZL_H
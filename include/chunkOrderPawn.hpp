@@ -0,0 +1,134 @@
+/*!
+ * @file
+ * class ChunkTagPawn and ChunkOrderPawn, units for passing the rows of all
+ * the processes on in one process in the order of the ranks.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef CHUNKORDERPAWN_EZL_H
+#define CHUNKORDERPAWN_EZL_H
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <ezl/pipeline/Link.hpp>
+
+namespace ezl {
+
+/*!
+ * @ingroup units
+ * Appends the rank, the number of the row in the process and if it is the
+ * last row of the process to the numeric columns of each row. A row is held
+ * back until the next comes in or the data ends, so that the last row is
+ * known when it is passed on.
+ * */
+class ChunkTagPawn
+    : public Link<std::tuple<const std::vector<std::string>&, const std::vector<double>&>,
+                  std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+
+  ChunkTagPawn(int rank) : _rank{double(rank)} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    if (_isHeld) _pass(false);
+    _s = std::get<0>(data);
+    _v = std::get<1>(data);
+    _isHeld = true;
+  }
+
+private:
+  void _pass(bool isLast) {
+    _v.push_back(_rank);
+    _v.push_back(double(_seq++));
+    _v.push_back(isLast ? 1.0 : 0.0);
+    rowT res{_s, _v};
+    for (auto &it : this->next()) {
+      it.second->dataEvent(res);
+    }
+  }
+
+  virtual void _dataEnd(int) override final {
+    if (_isHeld) _pass(true);
+    _isHeld = false;
+    _seq = 0;
+  }
+
+  double _rank;
+  size_t _seq{0};
+  bool _isHeld{false};
+  std::vector<std::string> _s;
+  std::vector<double> _v;
+};
+
+/*!
+ * @ingroup units
+ * Takes the rows tagged by ChunkTagPawn in the processes and passes them on
+ * without the tags in the order of the rank and then of the row. The rows of
+ * the rank that is due are passed on as they come in and the others are
+ * kept until their turn, at the end of data whatever is kept is passed on
+ * in order, as for a rank that had no rows.
+ * */
+class ChunkOrderPawn
+    : public Link<std::tuple<const std::vector<std::string>&, const std::vector<double>&>,
+                  std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+
+  virtual void dataEvent(const rowT &data) override final {
+    const auto &v = std::get<1>(data);
+    auto n = v.size() - 3;
+    auto at = std::make_pair(int(v[n]), size_t(v[n + 1]));
+    auto isLast = v[n + 2] != 0;
+    if (at != std::make_pair(_rank, _seq)) {
+      _held[at] = std::make_tuple(std::get<0>(data), std::vector<double>(std::begin(v), std::begin(v) + n), isLast);
+      return;
+    }
+    _v.assign(std::begin(v), std::begin(v) + n);
+    _pass(std::get<0>(data), _v, isLast);
+    while (!_held.empty() && _held.begin()->first == std::make_pair(_rank, _seq)) _passHeld();
+  }
+
+private:
+  void _pass(const std::vector<std::string> &s, const std::vector<double> &v, bool isLast) {
+    rowT res{s, v};
+    for (auto &it : this->next()) {
+      it.second->dataEvent(res);
+    }
+    if (isLast) {
+      ++_rank;
+      _seq = 0;
+    } else {
+      ++_seq;
+    }
+  }
+
+  void _passHeld() {
+    auto it = _held.begin();
+    _pass(std::get<0>(it->second), std::get<1>(it->second), std::get<2>(it->second));
+    _held.erase(it);
+  }
+
+  virtual void _dataEnd(int) override final {
+    while (!_held.empty()) _passHeld();
+    _rank = 0;
+    _seq = 0;
+  }
+
+  int _rank{0};
+  size_t _seq{0};
+  std::map<std::pair<int, size_t>, std::tuple<std::vector<std::string>, std::vector<double>, bool>> _held;
+  std::vector<double> _v;
+};
+} // namespace ezl
+
+#endif // !CHUNKORDERPAWN_EZL_H
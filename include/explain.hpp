@@ -0,0 +1,98 @@
+#if !defined(PAWN_EXPLAIN)
+#define PAWN_EXPLAIN
+
+#include <chrono>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <helper.hpp>
+
+namespace client { namespace helper {
+
+// a unit of the physical plan and its counters for explain analyze
+struct UnitStats {
+  std::string name;
+  std::vector<int> ranks;   // empty if it runs in the processes of the prior unit
+  std::string shuffle;      // description of the shuffle prior to the unit
+  bool isSource{false};
+  bool isTable{false};      // keeps its groups in a hash table
+  size_t tablePeak{0};      // the most groups in the table at once
+  long long rowsIn{0};
+  long long rowsOut{0};
+  long long bytes{0};
+  double wall{0};
+  double cpu{0};
+};
+
+class Explain {
+public:
+  Explain(bool analyze) : _analyze{analyze} {}
+
+  bool analyze() const { return _analyze; }
+
+  // adds a unit to the plan, returns its counters only if analyzing
+  UnitStats *add(std::string name, std::vector<int> ranks = {}, std::string shuffle = "");
+
+  void start();
+  void stop();
+
+  // collects the counters from all the processes and prints on rank 0
+  void print() const;
+
+private:
+  bool _analyze;
+  std::deque<UnitStats> _units;
+  std::chrono::steady_clock::time_point _begin;
+  double _wall{0};
+  std::clock_t _cpuBegin{0};
+  double _cpu{0};
+};
+
+// counts the rows in and adds the wall and the cpu time spent till it goes
+// out of scope
+class UnitTimer {
+public:
+  UnitTimer(UnitStats *s, long long n = 1) : _s{s} {
+    if (!_s) return;
+    _s->rowsIn += n;
+    _t = std::chrono::steady_clock::now();
+    _c = std::clock();
+  }
+  ~UnitTimer() {
+    if (!_s) return;
+    _s->wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - _t).count();
+    _s->cpu += double(std::clock() - _c) / CLOCKS_PER_SEC;
+  }
+  void out(long long n = 1) { if (_s) _s->rowsOut += n; }
+private:
+  UnitStats *_s;
+  std::chrono::steady_clock::time_point _t;
+  std::clock_t _c{0};
+};
+
+long long rowBytes(const std::vector<std::string> &s, const std::vector<double> &v);
+
+// pass through filter that counts the rows out of a unit or, on the input of
+// a shuffle, the rows in and their bytes
+struct RowCounter {
+  UnitStats *st;
+  bool isIn;
+  bool operator()(const std::vector<std::string> &s, const std::vector<double> &v) const {
+    if (isIn) {
+      ++st->rowsIn;
+      st->bytes += rowBytes(s, v);
+    } else {
+      ++st->rowsOut;
+    }
+    return true;
+  }
+};
+
+// shuffle keys as in the query e.g. %C_ID %3
+std::string keysText(const ColIndices &c);
+
+}}
+
+#endif
@@ -88,6 +88,8 @@ struct FromFilePawnProps
   std::vector<int> drop;
   std::vector<std::string> dropHead;
   std::function<std::pair<bool, rsPawn>(std::vector<std::string> &)> check;
+  std::function<bool(const std::vector<std::string> &, const std::vector<double> &)> where;
+  std::vector<int> whereNumeric;
   bool strict{true};
   bool tilleof{false};
   bool addFileName{false};
@@ -213,6 +215,21 @@ public:
     return std::move(*this);
   }
 
+  /*!
+   * predicate evaluated on the raw tokens of a row before the selected
+   * columns are converted. It gets all the tokens as strings and only the
+   * `colsNumeric` tokens as numbers, rows failing it are never materialized.
+   * */
+  auto where(
+      std::function<bool(const std::vector<std::string> &, const std::vector<double> &)> w,
+      std::vector<size_t> colsNumeric)
+  {
+    _props.where = w;
+    _props.whereNumeric.clear();
+    for (auto it : colsNumeric) _props.whereNumeric.push_back((int)it);
+    return std::move(*this);
+  }
+
   auto strictSchema(bool isStrict = true)
   {
     _props.strict = isStrict;
@@ -451,6 +468,12 @@ private:
     std::get<1>(_out).resize(_props.colsNumeric.size());
     auto uniq = std::set<int>(_props.cols.begin(), _props.cols.end());
     assert(uniq.size() == _props.cols.size() && "Duplicate column in select list.");
+    if (!_props.whereNumeric.empty())
+    {
+      _idealSize = std::max(_idealSize, *(std::max_element(
+                      begin(_props.whereNumeric), end(_props.whereNumeric))));
+    }
+    _whereNum.resize(_props.whereNumeric.size());
   }
 
   void _divideFiles(int pos, std::vector<int> procs)
@@ -544,6 +567,11 @@ private:
       st.first = false;
       return st;
     }
+    if (_props.where && !_rawWhere(vstr))
+    {
+      st.first = false;
+      return st;
+    }
     /*
     std::vector<std::string> temp;
     temp.reserve(_idealSize);
@@ -555,6 +583,18 @@ private:
     return st;
   }
 
+  // parses only the tokens the where predicate needs
+  bool _rawWhere(const std::vector<std::string> &vstr)
+  {
+    auto i = 0;
+    for (auto it : _props.whereNumeric)
+    {
+      if (!client::helper::lexCastNumPawn(vstr[it - 1], _whereNum[i++], _props.strict))
+        return false;
+    }
+    return _props.where(vstr, _whereNum);
+  }
+
   bool _nextFile()
   {
     if (_pos == -1 || _rBeginFile == -1)
@@ -672,6 +712,7 @@ private:
 
   using rowT = std::tuple<std::vector<std::string>, std::vector<double>>;
   rowT _out;
+  std::vector<double> _whereNum;
   long long _cur{-1};
   std::unique_ptr<std::filebuf> _fb{nullptr};
   std::unique_ptr<std::istream> _is{nullptr};
@@ -66,6 +66,20 @@ bool lexCastPawn(std::vector<std::string> &vstr,
                  std::vector<int> colsString, std::vector<int> colsNumeric,
                  bool strict);
 
+bool lexCastNumPawn(const std::string &s, double &out, bool strict);
+
+// order of the values of a column declared sorted, numbers by their value
+// before the other strings in their own order
+bool sortedLess(const std::string &a, const std::string &b);
+
+// a key per line, blank lines are skipped. false if the file cannot be read
+bool readKeys(const std::string &fname, std::vector<std::string> &out);
+
+// bytes that the groups of a reduce may take in a process before these are
+// spilled to disk, PAWN_REDUCE_MEMORY in MB if set with 0 for no limit, or
+// else half of the memory shared by the processes
+size_t reduceBudget(int nProc);
+
 }}
 
 #endif
\ No newline at end of file
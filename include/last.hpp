@@ -98,6 +98,33 @@ namespace client { namespace logical { namespace ast
         }
     };
 
+    // variables and columns an expression refers to
+    struct depsEval {
+    private:
+        using ColIndices = client::helper::ColIndices;
+    public:
+        using result_type = ColIndices;
+        result_type operator()(bool n) const { return result_type{}; }
+
+        result_type operator()(client::relational::ast::expr const& x) const {
+          return client::relational::ast::depsEval{}(x);
+        }
+
+        result_type operator()(unary const& x) const {
+          return boost::apply_visitor(*this, x.operand_);
+        }
+
+        result_type operator()(operation const& x) const {
+          return boost::apply_visitor(*this, x.operand_);
+        }
+
+        result_type operator()(expr const& e) const {
+            auto res = boost::apply_visitor(*this, e.first);
+            for (const auto& oper : e.rest) res.add((*this)(oper));
+            return res;
+        }
+    };
+
     struct colsEval {
     private:
         using ColIndices = client::helper::ColIndices;
@@ -14,9 +14,11 @@
 #include <boost/optional.hpp>
 #include <list>
 #include <map>
+#include <tuple>
 #include <dlfcn.h>
 
 #include <helper.hpp>
+#include <plugin.hpp>
 
 namespace client { namespace logicalc { namespace ast {
 
@@ -38,6 +40,9 @@ namespace client { namespace logicalc { namespace ast {
         }
     };
 
+    using client::plugin::openLib;
+    using client::plugin::abiVersion;
+
     struct colsEval {
     private:
         using ColIndices = client::helper::ColIndices;
@@ -49,15 +54,19 @@ namespace client { namespace logicalc { namespace ast {
         void setHeaders(const std::vector<std::string>& h) {}
         void notInitial() {}
         result_type operator()(expr const& e) const {
-            auto pLib = ::dlopen(e.path.val.c_str(), RTLD_LAZY);
+            auto pLib = openLib(e.path.val);
             if (!pLib) {
                 return std::make_pair(ColIndices{}, std::string{"Error opening " + e.path.val});
             }
             auto fn = ::dlsym(pLib, e.fn.c_str());
             if (!fn) {
-                std::make_pair(ColIndices{}, std::string{"Error locating " + e.fn + " in " + e.path.val});
+                return std::make_pair(ColIndices{}, std::string{"Error locating " + e.fn + " in " + e.path.val});
+            }
+            auto version = abiVersion(pLib);
+            if (version != 0 && version != PAWN_ABI_VERSION) {
+                return std::make_pair(ColIndices{}, "Error: " + e.path.val + " is built for plugin ABI version " +
+                                      std::to_string(version) + ", expected " + std::to_string(PAWN_ABI_VERSION));
             }
-            ::dlclose(pLib);
             return result_type{}; 
         }
     };
@@ -69,28 +78,31 @@ namespace client { namespace logicalc { namespace ast {
       bool _x;
     };
     struct evaluator {
-    private:
-        void *pLib = nullptr;
     public:
         using sigT = bool(const std::vector<std::string>&, const std::vector<double>&);
         using retFnT = std::function<sigT>;
+        enum { batchRows = 1024 };
         evaluator() {}
         evaluator(helper::positionTeller, const helper::Global &) {}
         typedef retFnT result_type;
 
         retFnT operator()(expr const& x)
         {
-            pLib = ::dlopen(x.path.val.c_str(), RTLD_LAZY);
+            auto pLib = openLib(x.path.val);
             if (!pLib) return whatever{true};
             auto fn = (sigT*)(::dlsym(pLib, x.fn.c_str()));
             if (!fn) return whatever{true};
-            //::dlclose(pLib);
             return fn;//static_cast<sigT*>(fn);
         }
 
-        ~evaluator() {
-            if (!pLib or pLib == nullptr) return;
-            ::dlclose(pLib);
+        // true if the library takes a batch of rows per call
+        bool isBatch(expr const& x) const {
+            auto pLib = openLib(x.path.val);
+            return pLib && abiVersion(pLib) == PAWN_ABI_VERSION;
+        }
+
+        pawnFilterFn *batch(expr const& x) const {
+            return (pawnFilterFn *)(::dlsym(openLib(x.path.val), x.fn.c_str()));
         }
     };
 }}}
@@ -16,15 +16,18 @@
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <helper.hpp>
+#include <plugin.hpp>
 
 namespace client { namespace math { namespace ast
 {
     struct nil {};
     struct unary;
     struct expr;
+    struct call;
 
     using variable = std::string;
     using column = unsigned int;
@@ -36,6 +39,7 @@ namespace client { namespace math { namespace ast
           , column
           , boost::recursive_wrapper<unary>
           , boost::recursive_wrapper<expr>
+          , boost::recursive_wrapper<call>
         >
     operand;
 
@@ -67,6 +71,14 @@ namespace client { namespace math { namespace ast
         std::list<operation> rest;
     };
 
+    // map from a shared library, cmd "lib.so" fn($a, $b)
+    struct call
+    {
+        std::string path;
+        std::string fn;
+        std::list<expr> args;
+    };
+
     // print functions for debugging
     inline std::ostream& operator<<(std::ostream& out, nil) { out << "nil"; return out; }
     //inline std::ostream& operator<<(std::ostream& out, variable const& var) { out << var.name; return out; }
@@ -111,6 +123,54 @@ namespace client { namespace math { namespace ast
                 (*this)(oper);
             }
         }
+
+        void operator()(call const& x) const
+        {
+            std::cout << "cmd \"" << x.path << "\" " << x.fn << '(';
+            auto first = true;
+            for (const auto& arg : x.args) {
+                if (!first) std::cout << ", ";
+                first = false;
+                (*this)(arg);
+            }
+            std::cout << ')';
+        }
+    };
+
+    // variables and columns an expression refers to
+    struct depsEval {
+    private:
+      using ColIndices = client::helper::ColIndices;
+    public:
+        using result_type = ColIndices;
+        result_type operator()(nil) const { return result_type{}; }
+        result_type operator()(double n) const { return result_type{}; }
+        result_type operator()(variable const &x) const {
+          ColIndices res;
+          res.var.push_back(x);
+          return res;
+        }
+        result_type operator()(column const &x) const {
+          ColIndices res;
+          res.num.push_back(x);
+          return res;
+        }
+        result_type operator()(unary const& x) const {
+          return boost::apply_visitor(*this, x.operand_);
+        }
+        result_type operator()(operation const& x) const {
+            return boost::apply_visitor(*this, x.operand_);
+        }
+        result_type operator()(expr const& e) const {
+            auto res = boost::apply_visitor(*this, e.first);
+            for (const auto& oper : e.rest) res.add((*this)(oper));
+            return res;
+        }
+        result_type operator()(call const& x) const {
+            result_type res{};
+            for (const auto& arg : x.args) res.add((*this)(arg));
+            return res;
+        }
     };
 
     struct colsEval {
@@ -160,6 +220,17 @@ namespace client { namespace math { namespace ast
             }
             return res;
         }
+        result_type operator()(call const& x) const {
+            result_type res{};
+            res.second = client::plugin::check(x.path, {x.fn});
+            if (res.second.size() > 0) return res;
+            for (const auto& arg : x.args) {
+              auto y = (*this)(arg);
+              if (y.second.size() > 0) return y;
+              res.first.add(y.first);
+            }
+            return res;
+        }
     };
 
     ///////////////////////////////////////////////////////////////////////////
@@ -239,6 +310,23 @@ namespace client { namespace math { namespace ast
             }
             return state;
         }
+
+        // called with a single row batch of the argument values, the buffer
+        // is shared by the copies of the closure
+        retFnT operator()(call const& x) const
+        {
+            std::vector<retFnT> args;
+            for (const auto& arg : x.args) args.push_back((*this)(arg));
+            auto fn = client::plugin::symbol<pawnMapFn>(x.path, x.fn);
+            auto buf = std::make_shared<std::vector<double>>(args.size());
+            return [args, fn, buf](const std::vector<double> &v) {
+                for (size_t i = 0; i < args.size(); ++i) (*buf)[i] = args[i](v);
+                pawnBatch b{1, 0, buf->size(), nullptr, nullptr, buf->data()};
+                double out = 0.;
+                fn(&b, &out);
+                return out;
+            };
+        }
     };
 }}}
 
@@ -259,4 +347,11 @@ BOOST_FUSION_ADAPT_STRUCT(
     (client::math::ast::operand, first)
     (std::list<client::math::ast::operation>, rest)
 )
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::math::ast::call,
+    (std::string, path)
+    (std::string, fn)
+    (std::list<client::math::ast::expr>, args)
+)
 #endif
@@ -25,7 +25,8 @@ namespace client { namespace math { namespace parser
           expr, additive_expr, multiplicative_expr;
         qi::rule<Iterator, ast::operand(), ascii::space_type> 
           unary_expr, primary_expr;
-        qi::rule<Iterator, std::string(), ascii::space_type> identifier;
+        qi::rule<Iterator, ast::call(), ascii::space_type> call;
+        qi::rule<Iterator, std::string(), ascii::space_type> identifier, name, quoted;
         qi::rule<Iterator, unsigned int, ascii::space_type> colIndex;
         qi::symbols<char, ast::optoken> additive_op, multiplicative_op, unary_op;
         qi::symbols<char>
@@ -74,9 +74,16 @@ namespace client { namespace math { namespace parser
                 double_
             |   identifier
             |   colIndex
+            |   call
             |   '(' >> expr >> ')'
             ;
 
+        call = "cmd" >> quoted >> name >> '(' >> -(expr % ',') >> ')';
+
+        quoted = '"' >> raw[lexeme[*(char_ - '"')]] >> '"';
+
+        name = raw[lexeme[(alpha | '_') >> *(alnum | '_')]];
+
         identifier = '$' >> raw[lexeme[(alpha | '_') >> *(alnum | '_')]];
 
         colIndex = '$' >> uint_;
@@ -90,6 +97,7 @@ namespace client { namespace math { namespace parser
             (primary_expr)
             (identifier)
             (colIndex)
+            (call)
         );
 
         ///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,32 @@
+/*!
+ * @file
+ * function pawnTag, message tags for the units that exchange rows or
+ * partial results on their own.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef PAWNTAG_EZL_H
+#define PAWNTAG_EZL_H
+
+#include <boost/mpi.hpp>
+
+namespace ezl {
+
+/*!
+ * tags are taken from the top so as not to meet the ones that Karta gives
+ * to the tasks counting up from 1, the units are built in the same order
+ * on all the processes so a unit gets the same tag on each of them.
+ * */
+inline int pawnTag() {
+  static int count = 0;
+  return boost::mpi::environment::max_tag() - count++;
+}
+} // namespace ezl
+
+#endif // !PAWNTAG_EZL_H
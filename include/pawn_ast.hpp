@@ -32,17 +32,21 @@ using logicalExpr = client::logical::ast::expr;
 using logicalCmd = client::logicalc::ast::expr;
 using reduceExpr = client::reduce::ast::expr;
 
+using quoted_stringT = std::string;
+
+using identifierT = std::string;
+using strOperand = boost::variant<identifierT, unsigned int>;
+
+// sortedBy are the columns the rows of the file are declared to be sorted
+// on, sortedCols has their index
 struct src {
   std::string fname;
+  std::vector<strOperand> sortedBy;
   ColIndices colIndices;
   int index;
+  std::vector<size_t> sortedCols;
 };
 
-using quoted_stringT = std::string;
-
-using identifierT = std::string;
-using strOperand = boost::variant<identifierT, unsigned int>;
-
 struct map {
   identifierT identifier;
   mathExpr operation;
@@ -50,16 +54,87 @@ struct map {
 
 using filter = boost::variant<logicalExpr, logicalCmd>;
 
+// with grouping sets each row is reduced in the groups of every set, the
+// keys that are not in a set are "*" in its groups and $grouping has a bit
+// set for each of them, the first key in the highest bit. A rollup has the
+// sets of the keys and of each of their prefixes down to none. setCols has
+// the sets with the index of the columns.
 struct reduce {
+  bool rollup;
+  std::vector<std::vector<strOperand>> sets;
   std::vector<strOperand> cols;
   reduceExpr operation;
   ColIndices colIndices;
+  std::vector<std::vector<size_t>> setCols;
+};
+
+using numSrc = boost::variant<identifierT, uint_>;
+
+// the first n rows in the order of a numeric column
+struct topBy {
+  uint_ n;
+  numSrc col;
+  bool desc;
+};
+
+// the n most frequent keys with their counts
+struct topCount {
+  uint_ n;
+  std::vector<strOperand> cols;
+  ColIndices colIndices;
+};
+
+// rows sorted on a numeric column
+struct sortNum {
+  numSrc col;
+  bool desc;
+};
+
+// rows sorted on string columns, keys are the columns with the names in
+// the input headers replaced by their index
+struct sortStr {
+  std::vector<strOperand> cols;
+  bool desc;
+  std::vector<strOperand> keys;
+};
+
+enum class windowOp : int { sum, avg, min, max };
+
+struct windowAgg {
+  windowOp op;
+  numSrc col;
+};
+
+// aggregates over the last n rows, or the last n rows with the same keys,
+// appended to each row. keys are resolved as of sortStr.
+struct window {
+  uint_ n;
+  std::vector<strOperand> cols;
+  std::vector<windowAgg> aggs;
+  std::vector<strOperand> keys;
+};
+
+// name of the column of a window aggregate e.g. win_avg_Lain_1
+inline std::string windowName(const windowAgg &a, const std::vector<std::string> &headers) {
+  static const char *ops[] = {"sum", "avg", "min", "max"};
+  std::string col;
+  if (auto v = boost::get<identifierT>(&a.col)) col = *v;
+  else if (boost::get<uint_>(a.col) <= headers.size()) col = headers[boost::get<uint_>(a.col) - 1];
+  else col = std::to_string(boost::get<uint_>(a.col));
+  return std::string{"win_"} + ops[int(a.op)] + "_" + col;
+}
+
+// variables of the maps that no later unit reads, put by the planner where
+// the rows are sent to other processes so that these are left out
+struct dropVars {
+  std::vector<identifierT> vars;
 };
 
 struct zipExpr;
 
 using unit =
-    boost::variant<map, filter, reduce, boost::recursive_wrapper<zipExpr>>;
+    boost::variant<map, filter, reduce, topBy, topCount, sortNum, sortStr, window, dropVars,
+                   boost::recursive_wrapper<zipExpr>>;
 
 struct zipExpr {
   std::vector<strOperand> cols;
@@ -69,8 +144,6 @@ struct zipExpr {
   int zipCount;
 };
 
-using numSrc = boost::variant<identifierT, uint_>;
-
 struct saveNum {
   numSrc src;
   identifierT dest;
@@ -93,7 +166,10 @@ using saveVal = std::vector<boost::variant<saveNum, saveStr>>;
 
 using terminal = boost::variant<queryName, saveVal, fileName>;
 
+enum class explainT : int { none, plan, analyze };
+
 struct expr {
+  explainT explain{explainT::none};
   src first;
   std::list<unit> units;
   terminal last;
@@ -139,6 +215,18 @@ struct printer {
     }
   };
 
+  void print(src const &s) const {
+    std::cout << s.index << ": file " << s.fname;
+    if (!s.sortedBy.empty()) {
+      std::cout << " sorted by";
+      for (auto& it : s.sortedBy) {
+        std::cout << " %";
+        boost::apply_visitor(printStrOperand{}, it);
+      }
+    }
+    std::cout << " | ";
+  }
+
   void operator()(zipExpr const &z) const {
     std::cout << "zip ";
     if (!z.cols.empty()) {
@@ -148,7 +236,7 @@ struct printer {
       }
     }
     std::cout << "(";
-    std::cout << z.first.index << ": file " << z.first.fname << " | ";
+    print(z.first);
     client::helper::print(z.first.colIndices);
     for (const auto &it : z.units) {
       boost::apply_visitor(*this, it);
@@ -169,10 +257,71 @@ struct printer {
         std::cout << ", ";
       }
     }
+    if (r.rollup) std::cout << " rollup";
+    for (auto& it : r.sets) {
+      std::cout << " (";
+      for (auto& jt : it) {
+        boost::apply_visitor(printStrOperand{}, jt);
+        std::cout << " ";
+      }
+      std::cout << ")";
+    }
     client::helper::print(r.colIndices);
     std::cout << " | ";
   }
 
+  void operator()(topBy const &t) const {
+    std::cout << "top " << t.n << " by ";
+    boost::apply_visitor(printStrOperand{}, t.col);
+    if (t.desc) std::cout << " desc";
+    std::cout << " | ";
+  }
+
+  void operator()(topCount const &t) const {
+    std::cout << "top " << t.n << " by count of ";
+    for (auto& it : t.cols) {
+      boost::apply_visitor(printStrOperand{}, it);
+      std::cout << ", ";
+    }
+    client::helper::print(t.colIndices);
+    std::cout << " | ";
+  }
+
+  void operator()(sortNum const &t) const {
+    std::cout << "sort by ";
+    boost::apply_visitor(printStrOperand{}, t.col);
+    if (t.desc) std::cout << " desc";
+    std::cout << " | ";
+  }
+
+  void operator()(sortStr const &t) const {
+    std::cout << "sort by ";
+    for (auto& it : t.cols) {
+      boost::apply_visitor(printStrOperand{}, it);
+      std::cout << ", ";
+    }
+    if (t.desc) std::cout << "desc";
+    std::cout << " | ";
+  }
+
+  void operator()(window const &w) const {
+    std::cout << "window " << w.n << " ";
+    for (auto& it : w.cols) {
+      boost::apply_visitor(printStrOperand{}, it);
+      std::cout << ", ";
+    }
+    for (auto& it : w.aggs) {
+      std::cout << windowName(it, {}) << " ";
+    }
+    std::cout << " | ";
+  }
+
+  void operator()(dropVars const &d) const {
+    std::cout << "drop ";
+    for (auto& it : d.vars) std::cout << it << " ";
+    std::cout << " | ";
+  }
+
   void operator()(const saveNum &s) const {
     std::cout << " saveNum from ";
     boost::apply_visitor(printStrOperand{}, s.src);
@@ -202,7 +351,9 @@ struct printer {
   }
 
   void operator()(expr const &x) const {
-    std::cout << x.first.index << ": file " << x.first.fname << " | ";
+    if (x.explain == explainT::plan) std::cout << "explain ";
+    if (x.explain == explainT::analyze) std::cout << "explain analyze ";
+    print(x.first);
     client::helper::print(x.first.colIndices);
     for (const auto &it : x.units) {
       boost::apply_visitor(*this, it);
@@ -231,6 +382,13 @@ private:
   state _st{state::none};
   int _zipCount = 0;
   std::vector<std::string> _headers;
+  // variables dropped from the rows since the last reduce, these are not in
+  // the columns after a zip
+  std::vector<std::string> _dropped;
+
+  bool isDropped(const std::string &var) const {
+    return std::find(begin(_dropped), end(_dropped), var) != end(_dropped);
+  }
 
   struct colsOperand {
     using result_type = std::pair<unsigned int, std::string>;
@@ -392,14 +550,64 @@ public:
   result_type operator()(reduce &r) {
     std::string err;
     *_pre = _cur; // value of what pre was pointing to is changed
+    _dropped.clear();
+    // string columns of approx_distinct are loaded like the keys
+    for (const auto &it : client::reduce::ast::strOperands(r.operation)) {
+      if (_isInitial) {
+        auto x = boost::apply_visitor(colsOperand{_headers, _pre->varStr}, it);
+        if (x.second.size() > 0) return x.second;
+        if (x.first) _pre->str.push_back(x.first);
+      } else {
+        auto x = boost::apply_visitor(chekStrOperand{*_pre, _headers}, it);
+        if (x.second.size() > 0) return x.second;
+      }
+    }
     std::tie(_cur, err) = _aeval(r.operation);
     if (err.size() > 0) return err;
-    for (auto& it : r.cols) {
+    err = groupingSets(r);
+    if (err.size() > 0) return err;
+    if (!r.sets.empty()) _cur.var.push_back("grouping");
+    return groupBy(r.cols, r.colIndices);
+  }
+
+  // the keys of a reduce with grouping sets are all the columns in the sets
+  std::string groupingSets(reduce &r) {
+    if (r.rollup) {
+      r.sets.clear();
+      for (auto i = r.cols.size() + 1; i-- > 0;) {
+        r.sets.emplace_back(begin(r.cols), begin(r.cols) + i);
+      }
+    } else if (!r.sets.empty()) {
+      if (!r.cols.empty()) return "Error: the keys of reduce sets are the columns in the sets.";
+      for (const auto &it : r.sets) {
+        for (const auto &jt : it) {
+          if (std::find(begin(r.cols), end(r.cols), jt) == end(r.cols)) r.cols.push_back(jt);
+        }
+      }
+    }
+    r.setCols.clear();
+    for (const auto &it : r.sets) {
+      std::vector<size_t> cols;
+      for (const auto &jt : it) {
+        auto x = boost::apply_visitor(colsOperand{_headers, _pre->varStr}, jt);
+        if (x.second.size() > 0) return x.second;
+        if (!x.first) return "Error: grouping sets can only have the columns of the file.";
+        cols.push_back(x.first);
+      }
+      r.setCols.push_back(std::move(cols));
+    }
+    return "";
+  }
+
+  // keys of a unit that gives a row for each group, the current columns
+  // are its output columns
+  std::string groupBy(const std::vector<strOperand> &cols, ColIndices &colIndices) {
+    for (auto& it : cols) {
       auto colNumErr = boost::apply_visitor(colsOperand{_headers, _pre->varStr}, it);
       if (colNumErr.second.size() > 0) return colNumErr.second;
       _cur.str.push_back(colNumErr.first);
     }
-    err = hitReduce(_cur);
+    auto err = hitReduce(_cur);
     if (err.size() > 0) return err;
     if (_st == state::first) {
       std::copy(begin(_cur.str), end(_cur.str), back_inserter(_pre->str));
@@ -409,14 +617,78 @@ public:
     _pre->uniq();
     _pre->sort();
     helper::processHeader(*_pre, _headers);
-    _pre = &(r.colIndices);
+    _pre = &colIndices;
     return err;
   }
 
+  std::string numOperand(const numSrc &col) {
+    if (_isInitial) {
+      auto x = boost::apply_visitor(colsOperand{_headers, _cur.var}, col);
+      if (x.first) _cur.num.push_back(x.first);
+      return x.second;
+    }
+    return boost::apply_visitor(chekNumOperand{_cur, _headers}, col).second;
+  }
+
+  result_type operator()(topBy const &t) { return numOperand(t.col); }
+
+  result_type operator()(sortNum const &t) { return numOperand(t.col); }
+
+  // string columns that a unit reads the rows with, the names in the input
+  // headers are replaced by their index in keys
+  std::string strKeys(const std::vector<strOperand> &cols, std::vector<strOperand> &keys) {
+    keys.clear();
+    for (const auto &it : cols) {
+      std::pair<unsigned int, std::string> x;
+      if (_isInitial) x = boost::apply_visitor(colsOperand{_headers, _cur.varStr}, it);
+      else x = boost::apply_visitor(chekStrOperand{_cur, _headers}, it);
+      if (x.second.size() > 0) return x.second;
+      if (!x.first) {
+        keys.push_back(it);
+        continue;
+      }
+      if (_isInitial) _cur.str.push_back(x.first);
+      keys.push_back(strOperand{x.first});
+    }
+    return "";
+  }
+
+  result_type operator()(sortStr &t) { return strKeys(t.cols, t.keys); }
+
+  result_type operator()(window &w) {
+    if (w.n == 0) return "Error: a window has at least one row.";
+    auto err = strKeys(w.cols, w.keys);
+    if (err.size() > 0) return err;
+    for (const auto &it : w.aggs) {
+      err = numOperand(it.col);
+      if (err.size() > 0) return err;
+    }
+    for (const auto &it : w.aggs) {
+      auto name = windowName(it, _headers);
+      if (std::find(begin(_cur.var), end(_cur.var), name) != end(_cur.var)) return "Err: " + name + " redeclared.";
+      _cur.var.push_back(name);
+    }
+    return "";
+  }
+
+  result_type operator()(dropVars const &d) {
+    std::copy(begin(d.vars), end(d.vars), back_inserter(_dropped));
+    return "";
+  }
+
+  result_type operator()(topCount &t) {
+    *_pre = _cur;
+    _dropped.clear();
+    _cur = ColIndices{};
+    _cur.var = {"count", "count_err"};
+    return groupBy(t.cols, t.colIndices);
+  }
+
   result_type operator()(zipExpr &r) {
     *_pre = _cur;
     _zipCount += 1;
-    std::string err = colsEval{_global}.zipInternal(r, _zipCount);
+    colsEval branch{_global};
+    std::string err = branch.zipInternal(r, _zipCount);
     _zipCount = r.zipCount;
     if (err.size() > 0) return err;
     for (auto& it : r.cols) {
@@ -443,16 +715,32 @@ public:
     for (auto it : _cur.num) {
       temp.push_back(std::to_string(it) + nm1);
     }
-    std::move(begin(_cur.var), end(_cur.var), back_inserter(temp));
+    std::copy_if(begin(_cur.var), end(_cur.var), back_inserter(temp),
+                 [this](const std::string &v) { return !isDropped(v); });
     for (auto it : r.colIndices.num) {
       temp.push_back(std::to_string(it) + nm2);
     }
     _cur.num.clear();
     _cur.var = std::move(temp);
-    std::copy(begin(r.colIndices.var), end(r.colIndices.var), back_inserter(_cur.var));
+    std::copy_if(begin(r.colIndices.var), end(r.colIndices.var), back_inserter(_cur.var),
+                 [&branch](const std::string &v) { return !branch.isDropped(v); });
+    _dropped.clear();
     return result_type{};
   }
 
+  // the columns that the file is sorted by are only of the file itself
+  result_type sortedCols(src &s) {
+    s.sortedCols.clear();
+    for (const auto &it : s.sortedBy) {
+      auto x = boost::apply_visitor(colsOperand{_headers, {}}, it);
+      if (x.second.size() > 0) {
+        return "Error: sorted by %" + boost::get<identifierT>(it) + " is not a column of " + s.fname + ".";
+      }
+      s.sortedCols.push_back(x.first);
+    }
+    return "";
+  }
+
   result_type zipInternal(zipExpr &x, int zCount) {
     _pre = &x.first.colIndices;
     std::string inFile{x.first.fname.begin() + 1, x.first.fname.end() - 1};
@@ -460,6 +748,8 @@ public:
     _meval.setHeaders(_headers);
     _leval.setHeaders(_headers);
     _aeval.setHeaders(_headers);
+    auto err = sortedCols(x.first);
+    if (err.size() > 0) return err;
     _zipCount = zCount;
     x.first.index = zCount;
     for (auto& it : x.cols) {
@@ -488,6 +778,8 @@ public:
     _leval.setHeaders(_headers);
     _aeval.setHeaders(_headers);
     x.first.index = 0;
+    auto err = sortedCols(x.first);
+    if (err.size() > 0) return err;
     for (auto &it : x.units) {
       auto x = boost::apply_visitor(*this, it);
       if (x.size() > 0) return x;
@@ -558,6 +850,7 @@ BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::fileName, (std::string, name))
 
 BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::src,
                           (std::string, fname)
+                          (std::vector<client::pawn::ast::strOperand>, sortedBy)
                           /*(client::helper::ColIndices, colIndices)*/)
 
 BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::map,
@@ -565,10 +858,41 @@ BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::map,
                           (client::math::ast::expr, operation))
 
 BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::reduce,
+                          (bool, rollup)
+                          (std::vector<std::vector<client::pawn::ast::strOperand>>, sets)
                           (std::vector<client::pawn::ast::strOperand>, cols)
                           (client::reduce::ast::expr, operation)
                           /*(client::helper::ColIndices, colIndices)*/)
 
+BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::topBy,
+                          (unsigned int, n)
+                          (client::pawn::ast::numSrc, col)
+                          (bool, desc))
+
+BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::topCount,
+                          (unsigned int, n)
+                          (std::vector<client::pawn::ast::strOperand>, cols)
+                          /*(client::helper::ColIndices, colIndices)*/)
+
+BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::sortNum,
+                          (client::pawn::ast::numSrc, col)
+                          (bool, desc))
+
+BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::windowAgg,
+                          (client::pawn::ast::windowOp, op)
+                          (client::pawn::ast::numSrc, col))
+
+BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::window,
+                          (unsigned int, n)
+                          (std::vector<client::pawn::ast::strOperand>, cols)
+                          (std::vector<client::pawn::ast::windowAgg>, aggs)
+                          /*(std::vector<client::pawn::ast::strOperand>, keys)*/)
+
+BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::sortStr,
+                          (std::vector<client::pawn::ast::strOperand>, cols)
+                          (bool, desc)
+                          /*(std::vector<client::pawn::ast::strOperand>, keys)*/)
+
 BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::zipExpr,
                           (std::vector<client::pawn::ast::strOperand>, cols)
                           (client::pawn::ast::src, first)
@@ -576,6 +900,7 @@ BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::zipExpr,
                           /*(client::helper::ColIndices, colIndices)*/)
 
 BOOST_FUSION_ADAPT_STRUCT(client::pawn::ast::expr,
+                          (client::pawn::ast::explainT, explain)
                           (client::pawn::ast::src, first)
                           (std::list<client::pawn::ast::unit>, units)
                           (client::pawn::ast::terminal, last))
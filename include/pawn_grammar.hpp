@@ -26,6 +26,7 @@ namespace client { namespace pawn { namespace parser
         expression(error_handler<Iterator>& error_handler);
 
         qi::rule<Iterator, ast::expr(), ascii::space_type> expr;
+        qi::rule<Iterator, ast::explainT(), ascii::space_type> explain;
         qi::rule<Iterator, ast::src(), ascii::space_type> src;
         qi::rule<Iterator, ast::zipExpr(), ascii::space_type> zipExpr;
         qi::rule<Iterator, ast::quoted_stringT(), ascii::space_type> quoted_string;
@@ -33,6 +34,18 @@ namespace client { namespace pawn { namespace parser
         qi::rule<Iterator, ast::identifierT(), ascii::space_type> identifier;
         qi::rule<Iterator, ast::strOperand(), ascii::space_type> strOperand;
         qi::rule<Iterator, std::vector<ast::strOperand>(), ascii::space_type> reduceCols;
+        qi::rule<Iterator, ast::reduce(), ascii::space_type> reduce;
+        qi::rule<Iterator, bool(), ascii::space_type> rollup;
+        qi::rule<Iterator, std::vector<std::vector<ast::strOperand>>(), ascii::space_type> groupingSets;
+        qi::rule<Iterator, ast::topCount(), ascii::space_type> topCount;
+        qi::rule<Iterator, ast::topBy(), ascii::space_type> topBy;
+        qi::rule<Iterator, ast::numSrc(), ascii::space_type> numOperand;
+        qi::rule<Iterator, ast::sortStr(), ascii::space_type> sortStr;
+        qi::rule<Iterator, ast::sortNum(), ascii::space_type> sortNum;
+        qi::rule<Iterator, bool(), ascii::space_type> descOrder;
+        qi::rule<Iterator, ast::window(), ascii::space_type> window;
+        qi::rule<Iterator, ast::windowAgg(), ascii::space_type> windowAgg;
+        qi::symbols<char, ast::windowOp> windowOp;
         qi::rule<Iterator, ast::saveStr(), ascii::space_type> saveStr;
         qi::rule<Iterator, ast::saveNum(), ascii::space_type> saveNum;
         qi::rule<Iterator, ast::saveVal(), ascii::space_type> saveVal;
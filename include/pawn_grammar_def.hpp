@@ -1,6 +1,7 @@
 #include "pawn_grammar.hpp"
 //#include "error_handler.hpp"
 #include <boost/spirit/include/phoenix_function.hpp>
+#include <boost/spirit/include/phoenix_operator.hpp>
 
 namespace client { namespace pawn { namespace parser
 {
@@ -23,6 +24,9 @@ namespace client { namespace pawn { namespace parser
         qi::alnum_type alnum;
         qi::bool_type bool_;
         qi::double_type double_;
+        qi::lit_type lit;
+        qi::eps_type eps;
+        qi::attr_type attr;
 
         using qi::on_error;
         using qi::on_success;
@@ -31,21 +35,56 @@ namespace client { namespace pawn { namespace parser
 
         typedef function<client::error_handler<Iterator> > error_handler_function;
 
-        expr = src >> +('|' >> unit) >> '|' >> terminal;
+        expr = explain >> src >> +('|' >> unit) >> '|' >> terminal;
 
-        src = "file" >> quoted_string;
+        explain = (lit("explain") >> "analyze")[_val = ast::explainT::analyze]
+                | lit("explain")[_val = ast::explainT::plan]
+                | eps[_val = ast::explainT::none];
+
+        src = "file" >> quoted_string >> -(lit("sorted") >> "by" >> +strOperand);
 
         quoted_string = raw[lexeme['"' >> +(char_ - '"') >> '"']];
 
         unit = '$' >> identifier >> '=' >> mathExpr
              | "where" >> (logicalExpr | logicalCmd)
-             | "reduce" >> reduceCols >> reduceExpr
+             | "reduce" >> reduce
+             | "top" >> topCount
+             | "top" >> topBy
+             | "sort" >> sortStr
+             | "sort" >> sortNum
+             | "window" >> window
              | "zip" >> zipExpr;
 
         zipExpr = reduceCols >> '('  >> src >> *('|' >> unit) >> ')'; ;
         
         reduceCols = *(strOperand);
 
+        reduce = rollup >> groupingSets >> reduceCols >> reduceExpr;
+
+        rollup = (lit("rollup") >> attr(true)) | attr(false);
+
+        groupingSets = ("sets" >> +('(' >> reduceCols >> ')'))
+                     | attr(std::vector<std::vector<ast::strOperand>>());
+
+        topCount = uint_ >> +strOperand >> "by" >> "count";
+
+        topBy = uint_ >> "by" >> numOperand >> descOrder;
+
+        sortStr = +strOperand >> descOrder;
+
+        sortNum = numOperand >> descOrder;
+
+        descOrder = (lit("desc") >> attr(true)) | attr(false);
+
+        window = uint_ >> reduceCols >> +windowAgg;
+
+        windowAgg = windowOp >> '(' >> numOperand >> ')';
+
+        windowOp.add("sum", ast::windowOp::sum)("avg", ast::windowOp::avg)
+                    ("min", ast::windowOp::min)("max", ast::windowOp::max);
+
+        numOperand = '$' >> (identifier | uint_);
+
         identifier =  raw[lexeme[(alpha | '_') >> *(alnum | '_')]];
 
         strOperand = '%' >> (identifier | uint_);
@@ -68,11 +107,23 @@ namespace client { namespace pawn { namespace parser
         // Debugging and error handling and reporting support.
         BOOST_SPIRIT_DEBUG_NODES(
             (expr)
+            (explain)
             (src)
             (quoted_string)
             (zipExpr)
             (unit)
             (reduceCols)
+            (reduce)
+            (rollup)
+            (groupingSets)
+            (topCount)
+            (topBy)
+            (numOperand)
+            (sortStr)
+            (sortNum)
+            (descOrder)
+            (window)
+            (windowAgg)
             (identifier)
             (strOperand)
             (saveStr)
@@ -0,0 +1,210 @@
+#if !defined(PAWN_PLANNER_HPP)
+#define PAWN_PLANNER_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <helper.hpp>
+#include <pawn_ast.hpp>
+
+namespace client {
+namespace pawn {
+namespace ast {
+
+///////////////////////////////////////////////////////////////////////////
+//  The logical planner, rewrites the units before the cols evaluation.
+//  - maps that no later unit refers to are removed.
+//  - the variables of the maps that no later unit refers to are dropped
+//    from the rows before a top, a sort, a window or a zip sends them to
+//    other processes, and at the end of a zip branch.
+//  - filters are hoisted above the maps they do not depend on.
+//  - a filter right after a zip that reads only the zip keys is hoisted
+//    above it. The zip pairs the rows of a key on the two sides in order, so
+//    a filter that drops some of the rows of a key is not moved.
+//  Filters are never moved across a reduce, a top, a sort, a window or
+//  another filter, and a cmd filter keeps every column before it alive since
+//  it can read any of them.
+///////////////////////////////////////////////////////////////////////////
+struct planner {
+private:
+  using ColIndices = client::helper::ColIndices;
+  using Global = client::helper::Global;
+  using unitsT = std::list<unit>;
+  using namesT = std::set<std::string>;
+
+  const Global &_global;
+
+  static const logicalExpr *asExpr(const unit &u) {
+    auto f = boost::get<filter>(&u);
+    if (!f) return nullptr;
+    return boost::get<logicalExpr>(f);
+  }
+
+  static bool isCmd(const unit &u) {
+    auto f = boost::get<filter>(&u);
+    return f && boost::get<logicalCmd>(f);
+  }
+
+  // the filter reads nothing but the keys of the zip and the global values,
+  // it keeps or drops all the rows of a key on both sides alike
+  bool keysOnly(const ColIndices &deps, const zipExpr &z) const {
+    if (!deps.num.empty()) return false;
+    for (const auto &it : deps.var) {
+      if (!_global.gVarsN.count(it)) return false;
+    }
+    auto isKey = [&z](const strOperand &s) {
+      return std::find(begin(z.cols), end(z.cols), s) != end(z.cols);
+    };
+    for (auto it : deps.str) {
+      if (!isKey(strOperand{(unsigned int)it})) return false;
+    }
+    for (const auto &it : deps.varStr) {
+      if (!isKey(strOperand{it}) && !_global.gVarsS.count(it)) return false;
+    }
+    return true;
+  }
+
+  void hoist(unitsT &units) {
+    for (auto it = begin(units); it != end(units); ++it) {
+      auto f = asExpr(*it);
+      if (!f) continue;
+      auto deps = client::logical::ast::depsEval{}(*f);
+      auto pos = it;
+      while (pos != begin(units)) {
+        auto &pre = *std::prev(pos);
+        if (auto m = boost::get<map>(&pre)) {
+          if (std::find(begin(deps.var), end(deps.var), m->identifier) != end(deps.var)) break;
+        } else if (auto z = boost::get<zipExpr>(&pre)) {
+          if (!keysOnly(deps, *z)) break;
+        } else {
+          break;
+        }
+        --pos;
+      }
+      if (pos != it) units.splice(pos, units, it);
+    }
+  }
+
+  // removes maps not referred by later units and drops the variables of the
+  // maps that are not referred any more where the rows are sent on. live is
+  // the set of variables referred after the units and all if every column
+  // is referred. Gives the variables of the maps left at the end, the end of
+  // a zip branch is a point where the rows are sent on as well.
+  std::vector<std::string> prune(unitsT &units, bool all, namesT live, bool isBranch = false) {
+    // the units that send the rows on, with the variables referred from there
+    std::vector<std::pair<unitsT::iterator, namesT>> sends;
+    std::map<const zipExpr *, std::vector<std::string>> branchVars;
+    auto send = [&sends, &all, &live](unitsT::iterator at) {
+      if (!all) sends.emplace_back(at, live);
+    };
+    if (isBranch) send(end(units));
+    auto it = end(units);
+    while (it != begin(units)) {
+      --it;
+      if (auto m = boost::get<map>(&*it)) {
+        if (!all && !live.count(m->identifier)) {
+          it = units.erase(it);
+          continue;
+        }
+        auto deps = client::math::ast::depsEval{}(m->operation);
+        live.insert(begin(deps.var), end(deps.var));
+      } else if (auto f = asExpr(*it)) {
+        auto deps = client::logical::ast::depsEval{}(*f);
+        live.insert(begin(deps.var), end(deps.var));
+      } else if (isCmd(*it)) {
+        all = true;
+      } else if (auto r = boost::get<reduce>(&*it)) {
+        auto deps = client::reduce::ast::depsEval{}(r->operation);
+        all = false;
+        live = namesT{begin(deps.var), end(deps.var)};
+      } else if (auto t = boost::get<topBy>(&*it)) {
+        if (auto v = boost::get<identifierT>(&t->col)) live.insert(*v);
+        send(it);
+      } else if (auto t = boost::get<sortNum>(&*it)) {
+        if (auto v = boost::get<identifierT>(&t->col)) live.insert(*v);
+        send(it);
+      } else if (boost::get<sortStr>(&*it)) {
+        send(it);
+      } else if (auto w = boost::get<window>(&*it)) {
+        for (const auto &jt : w->aggs) {
+          if (auto v = boost::get<identifierT>(&jt.col)) live.insert(*v);
+        }
+        send(it);
+      } else if (boost::get<topCount>(&*it)) {
+        all = false;
+        live.clear();
+      } else if (auto z = boost::get<zipExpr>(&*it)) {
+        branchVars[z] = prune(z->units, all, live, true);
+        send(it);
+      }
+    }
+    // the variables of the maps so far are dropped before the units that
+    // send the rows on once these are not referred
+    std::reverse(begin(sends), end(sends));
+    auto at = begin(sends);
+    std::vector<std::string> vars;
+    for (it = begin(units);; ++it) {
+      if (at != end(sends) && at->first == it) {
+        dropVars d;
+        auto isLive = [&at](const std::string &v) { return at->second.count(v) > 0; };
+        std::copy_if(begin(vars), end(vars), back_inserter(d.vars), [&isLive](const std::string &v) { return !isLive(v); });
+        vars.erase(std::remove_if(begin(vars), end(vars), [&isLive](const std::string &v) { return !isLive(v); }), end(vars));
+        if (!d.vars.empty()) units.insert(it, std::move(d));
+        ++at;
+      }
+      if (it == end(units)) break;
+      if (auto m = boost::get<map>(&*it)) {
+        vars.push_back(m->identifier);
+      } else if (boost::get<reduce>(&*it) || boost::get<topCount>(&*it)) {
+        vars.clear();
+      } else if (auto z = boost::get<zipExpr>(&*it)) {
+        const auto &b = branchVars[z];
+        std::copy(begin(b), end(b), back_inserter(vars));
+      }
+    }
+    return vars;
+  }
+
+  struct terminalLive {
+    using result_type = std::pair<bool, namesT>;
+    result_type operator()(const queryName &) const { return result_type{true, {}}; }
+    result_type operator()(const fileName &) const { return result_type{true, {}}; }
+    result_type operator()(const saveVal &s) const {
+      result_type res{false, {}};
+      for (auto &it : s) {
+        auto n = boost::get<saveNum>(&it);
+        if (!n) continue;
+        if (auto v = boost::get<identifierT>(&n->src)) res.second.insert(*v);
+      }
+      return res;
+    }
+  };
+
+  void plan(unitsT &units) {
+    hoist(units);
+    for (auto &it : units) {
+      if (auto z = boost::get<zipExpr>(&it)) plan(z->units);
+    }
+  }
+
+public:
+  using result_type = void;
+  planner(const Global &global) : _global{global} {}
+
+  void operator()(expr &x) {
+    auto live = boost::apply_visitor(terminalLive{}, x.last);
+    prune(x.units, live.first, live.second);
+    plan(x.units);
+  }
+};
+
+} // namespace ast
+} // namespace pawn
+} // namespace client
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Batch ABI for the shared libraries loaded with `cmd "lib.so" fn`.
+ *
+ * A library opts in by exporting `unsigned pawnAbiVersion()` that returns
+ * PAWN_ABI_VERSION. Its entry points are then called once for a batch of rows
+ * instead of once for each row. A library without pawnAbiVersion is taken to
+ * export the per row filter
+ *   bool fn(const std::vector<std::string>&, const std::vector<double>&)
+ * Maps and aggregates are only loaded with the batch ABI.
+ *
+ * The header is plain C so that plugins need not share the compiler or the
+ * standard library of pawn.
+ */
+#if !defined(PAWN_PLUGIN_H)
+#define PAWN_PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAWN_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* columns of a batch of rows laid out column major, the string column c of
+ * row r is str[c * rows + r] with its length in strLen[c * rows + r], not
+ * null terminated. Numeric columns are likewise in num. */
+struct pawnBatch {
+  size_t rows;
+  size_t nStr;
+  size_t nNum;
+  const char *const *str;
+  const size_t *strLen;
+  const double *num;
+};
+
+/* sets the bit r % 64 of sel[r / 64] to keep the row r, sel comes zeroed */
+typedef void pawnFilterFn(const struct pawnBatch *batch, uint64_t *sel);
+
+/* `$x = cmd "lib.so" fn($a, $b)`, the arguments are the numeric columns of
+ * the batch, writes the value for the row r to out[r] */
+typedef void pawnMapFn(const struct pawnBatch *batch, double *out);
+
+/* `reduce %k cmd "lib.so" agg($a)` looks up agg_size, agg_init, agg_update,
+ * agg_merge and agg_final. The state of a group is agg_size() doubles, it is
+ * updated with batches of rows having the keys as string columns and the
+ * operand as the only numeric column. States from the processes are merged
+ * in the final reduce and agg_final gives the value of the group. */
+typedef size_t pawnAggSizeFn(void);
+typedef void pawnAggInitFn(double *state);
+typedef void pawnAggUpdateFn(double *state, const struct pawnBatch *batch);
+typedef void pawnAggMergeFn(double *state, const double *other);
+typedef double pawnAggFinalFn(const double *state);
+
+typedef unsigned pawnAbiVersionFn(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
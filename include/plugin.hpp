@@ -0,0 +1,58 @@
+#if !defined(PAWN_PLUGIN_HPP)
+#define PAWN_PLUGIN_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <dlfcn.h>
+
+#include <pawn_plugin.h>
+
+namespace client { namespace plugin {
+
+// libraries are opened once per process and stay open for the later
+// queries, nullptr if the library can not be opened
+inline void *openLib(const std::string &path) {
+  static std::mutex m;
+  static std::map<std::string, void *> libs;
+  std::lock_guard<std::mutex> lock{m};
+  auto it = libs.find(path);
+  if (it != std::end(libs)) return it->second;
+  auto pLib = ::dlopen(path.c_str(), RTLD_LAZY);
+  if (pLib) libs[path] = pLib;
+  return pLib;
+}
+
+// batch ABI version of the library, 0 for the per row filter
+inline unsigned abiVersion(void *pLib) {
+  auto fn = (pawnAbiVersionFn *)(::dlsym(pLib, "pawnAbiVersion"));
+  return fn ? fn() : 0;
+}
+
+// the symbol from the library, nullptr if either is missing
+template <class T>
+T *symbol(const std::string &path, const std::string &name) {
+  auto pLib = openLib(path);
+  if (!pLib) return nullptr;
+  return (T *)(::dlsym(pLib, name.c_str()));
+}
+
+// empty if the library exports the symbols with the supported ABI version
+inline std::string check(const std::string &path, std::initializer_list<std::string> names) {
+  auto pLib = openLib(path);
+  if (!pLib) return "Error opening " + path;
+  auto version = abiVersion(pLib);
+  if (version != PAWN_ABI_VERSION) {
+    return "Error: " + path + " is built for plugin ABI version " + std::to_string(version) +
+           ", expected " + std::to_string(PAWN_ABI_VERSION);
+  }
+  for (const auto &it : names) {
+    if (!::dlsym(pLib, it.c_str())) return "Error locating " + it + " in " + path;
+  }
+  return "";
+}
+
+}}
+
+#endif
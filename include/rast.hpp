@@ -9,11 +9,16 @@
 
 #include <boost/config/warning_disable.hpp>
 #include <boost/variant/recursive_variant.hpp>
+#include <boost/variant/get.hpp>
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <boost/fusion/include/io.hpp>
 #include <boost/optional.hpp>
+#include <algorithm>
 #include <list>
 #include <map>
+#include <memory>
+#include <regex>
+#include <unordered_set>
 
 #include "mast.hpp"
 #include "sast.hpp"
@@ -45,7 +50,187 @@ namespace client { namespace relational { namespace ast
         strOperand rhs;
     };
 
-    using expr = boost::variant<mathOp, strOp>;
+    struct inFile {
+        std::string name;
+    };
+
+    using mathSet = boost::variant<inFile, std::vector<double>>;
+    using strSet = boost::variant<inFile, std::vector<std::string>>;
+
+    struct mathIn {
+        mathOperand lhs;
+        mathSet set;
+    };
+
+    struct strIn {
+        strOperand lhs;
+        strSet set;
+    };
+
+    enum class matchtoken : int
+    {
+        like,
+        regex
+    };
+
+    struct strMatch {
+        strOperand lhs;
+        matchtoken operator_;
+        std::string pattern;
+    };
+
+    using expr = boost::variant<mathOp, strOp, mathIn, strIn, strMatch>;
+
+    // keys of an in predicate, read from the file if it lists them in one
+    inline std::string loadKeys(const strSet &s, std::vector<std::string> &out) {
+        if (auto f = boost::get<inFile>(&s)) {
+            if (!client::helper::readKeys(f->name, out)) return "Error: could not read keys from " + f->name;
+            return "";
+        }
+        out = boost::get<std::vector<std::string>>(s);
+        return "";
+    }
+
+    inline std::string loadKeys(const mathSet &s, std::vector<double> &out) {
+        if (auto n = boost::get<std::vector<double>>(&s)) {
+            out = *n;
+            return "";
+        }
+        const auto &name = boost::get<inFile>(s).name;
+        std::vector<std::string> keys;
+        if (!client::helper::readKeys(name, keys)) return "Error: could not read keys from " + name;
+        out.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!client::helper::lexCastNumPawn(keys[i], out[i], true)) {
+                return "Error: key " + keys[i] + " in " + name + " is not a number.";
+            }
+        }
+        return "";
+    }
+
+    // membership test for the in predicate, a handful of keys are scanned
+    // linearly and the rest go to a hash set built once per query
+    template <typename T>
+    class keySet {
+    public:
+        keySet(std::vector<T> keys) {
+            std::sort(begin(keys), end(keys));
+            keys.erase(std::unique(begin(keys), end(keys)), end(keys));
+            _isHashed = keys.size() > linearMax;
+            if (_isHashed) _hashed.insert(begin(keys), end(keys));
+            else _keys = std::move(keys);
+        }
+        bool has(const T &x) const {
+            if (_isHashed) return _hashed.count(x) > 0;
+            return std::find(begin(_keys), end(_keys), x) != end(_keys);
+        }
+    private:
+        enum { linearMax = 8 };
+        bool _isHashed;
+        std::vector<T> _keys;
+        std::unordered_set<T> _hashed;
+    };
+
+    // like and ~ patterns compiled once per query. Patterns that reduce to a
+    // literal, a prefix, a suffix or a substring are matched without regex;
+    // other like patterns use a wildcard scan and the rest std::regex.
+    class pattern {
+    public:
+        pattern(matchtoken o, const std::string &p) {
+            if (o == matchtoken::like) _like(p);
+            else _regex(p);
+        }
+        bool matches(const std::string &s) const {
+            switch (_kind) {
+                case kind::exact: return s == _lit;
+                case kind::prefix: return s.compare(0, _lit.size(), _lit) == 0;
+                case kind::suffix: return s.size() >= _lit.size() &&
+                                          s.compare(s.size() - _lit.size(), _lit.size(), _lit) == 0;
+                case kind::contains: return s.find(_lit) != std::string::npos;
+                case kind::wildcard: return _wildcard(s);
+                case kind::regex: return std::regex_search(s, _re);
+            }
+            return false;
+        }
+        // empty if the pattern compiles, the reason otherwise
+        static std::string check(matchtoken o, const std::string &p) {
+            try {
+                pattern{o, p};
+            } catch (const std::regex_error &e) {
+                return "Error: invalid regex \"" + p + "\", " + e.what();
+            }
+            return "";
+        }
+    private:
+        enum class kind { exact, prefix, suffix, contains, wildcard, regex };
+        kind _kind;
+        std::string _lit;
+        std::regex _re;
+
+        void _like(const std::string &p) {
+            _lit = p;
+            if (p.find('_') != std::string::npos) {
+                _kind = kind::wildcard;
+                return;
+            }
+            auto first = p.find('%');
+            if (first == std::string::npos) {
+                _kind = kind::exact;
+                return;
+            }
+            auto last = p.rfind('%');
+            auto inner = p.find('%', 1);
+            if (first == p.size() - 1) {
+                _kind = kind::prefix;
+                _lit.pop_back();
+            } else if (first == 0 && last == 0) {
+                _kind = kind::suffix;
+                _lit.erase(0, 1);
+            } else if (first == 0 && inner == p.size() - 1) {
+                _kind = kind::contains;
+                _lit = p.substr(1, p.size() - 2);
+            } else {
+                _kind = kind::wildcard;
+            }
+        }
+
+        void _regex(const std::string &p) {
+            bool front = !p.empty() && p.front() == '^';
+            bool back = p.size() > (front ? 1u : 0u) && p.back() == '$';
+            _lit = p.substr(front, p.size() - front - back);
+            if (_lit.find_first_of("\\.^$|?*+()[]{}") != std::string::npos) {
+                _kind = kind::regex;
+                _re = std::regex{p, std::regex::ECMAScript | std::regex::optimize};
+                return;
+            }
+            if (front && back) _kind = kind::exact;
+            else if (front) _kind = kind::prefix;
+            else if (back) _kind = kind::suffix;
+            else _kind = kind::contains;
+        }
+
+        // % matches any run of characters and _ a single one, backtracks
+        // only to the last %
+        bool _wildcard(const std::string &s) const {
+            size_t i = 0, j = 0;
+            size_t star = std::string::npos, mark = 0;
+            while (i < s.size()) {
+                if (j < _lit.size() && (_lit[j] == '_' || _lit[j] == s[i])) {
+                    ++i; ++j;
+                } else if (j < _lit.size() && _lit[j] == '%') {
+                    star = j++;
+                    mark = i;
+                } else if (star != std::string::npos) {
+                    j = star + 1;
+                    i = ++mark;
+                } else {
+                    return false;
+                }
+            }
+            while (j < _lit.size() && _lit[j] == '%') ++j;
+            return j == _lit.size();
+        }
+    };
 
     struct printer {
         typedef void result_type;
@@ -78,11 +263,75 @@ namespace client { namespace relational { namespace ast
             print(x.rhs);
         }
 
+        void operator()(inFile const& x) const { std::cout << "file \"" << x.name << '"'; }
+
+        void operator()(std::vector<double> const& x) const {
+            std::cout << '(';
+            for (size_t i = 0; i < x.size(); ++i) std::cout << (i ? ", " : "") << x[i];
+            std::cout << ')';
+        }
+
+        void operator()(std::vector<std::string> const& x) const {
+            std::cout << '(';
+            for (size_t i = 0; i < x.size(); ++i) std::cout << (i ? ", " : "") << '"' << x[i] << '"';
+            std::cout << ')';
+        }
+
+        void operator()(mathIn const& x) const {
+            client::math::ast::printer{}(x.lhs);
+            std::cout << " in ";
+            boost::apply_visitor(*this, x.set);
+        }
+
+        void operator()(strIn const& x) const {
+            client::str::ast::printer{}(x.lhs);
+            std::cout << " in ";
+            boost::apply_visitor(*this, x.set);
+        }
+
+        void operator()(strMatch const& x) const {
+            client::str::ast::printer{}(x.lhs);
+            std::cout << (x.operator_ == matchtoken::like ? " like " : " ~ ");
+            std::cout << '"' << x.pattern << '"';
+        }
+
         void operator()(expr const& x) const {
           boost::apply_visitor(*this, x);
         }
     };
 
+    // variables and columns an expression refers to
+    struct depsEval {
+    private:
+      using ColIndices = client::helper::ColIndices;
+    public:
+        using result_type = ColIndices;
+        result_type operator()(mathOp const& x) const {
+            client::math::ast::depsEval deps;
+            auto res = deps(x.lhs);
+            res.add(deps(x.rhs));
+            return res;
+        }
+        result_type operator()(strOp const& x) const {
+            client::str::ast::depsEval deps;
+            auto res = deps(x.lhs);
+            res.add(deps(x.rhs));
+            return res;
+        }
+        result_type operator()(mathIn const& x) const {
+            return client::math::ast::depsEval{}(x.lhs);
+        }
+        result_type operator()(strIn const& x) const {
+            return client::str::ast::depsEval{}(x.lhs);
+        }
+        result_type operator()(strMatch const& x) const {
+            return client::str::ast::depsEval{}(x.lhs);
+        }
+        result_type operator()(expr const& e) const {
+            return boost::apply_visitor(*this, e);
+        }
+    };
+
     struct colsEval {
     private:
       using ColIndices = client::helper::ColIndices;
@@ -118,6 +367,35 @@ namespace client { namespace relational { namespace ast
             res.first.add(y.first);
             return res;
         }
+        result_type operator()(mathIn const& x) const {
+            client::math::ast::colsEval mColsEval(_v, _global);
+            mColsEval.setHeaders(_headers);
+            if (!_isInitial) mColsEval.notInitial();
+            auto res = mColsEval(x.lhs);
+            if (res.second.size() > 0) return res;
+            std::vector<double> keys;
+            res.second = loadKeys(x.set, keys);
+            return res;
+        }
+        result_type operator()(strIn const& x) const {
+            client::str::ast::colsEval mColsEval(_v, _global);
+            mColsEval.setHeaders(_headers);
+            if (!_isInitial) mColsEval.notInitial();
+            auto res = mColsEval(x.lhs);
+            if (res.second.size() > 0) return res;
+            std::vector<std::string> keys;
+            res.second = loadKeys(x.set, keys);
+            return res;
+        }
+        result_type operator()(strMatch const& x) const {
+            client::str::ast::colsEval mColsEval(_v, _global);
+            mColsEval.setHeaders(_headers);
+            if (!_isInitial) mColsEval.notInitial();
+            auto res = mColsEval(x.lhs);
+            if (res.second.size() > 0) return res;
+            res.second = pattern::check(x.operator_, x.pattern);
+            return res;
+        }
         result_type operator()(expr const& e) const {
             return boost::apply_visitor(*this, e);
         }
@@ -178,6 +456,36 @@ namespace client { namespace relational { namespace ast
            return (*this)(x.operator_, _seval(x.lhs), _seval(x.rhs)); 
         }
 
+        retFnT operator()(mathIn const& x) const {
+            std::vector<double> keys;
+            loadKeys(x.set, keys);
+            auto set = std::make_shared<const keySet<double>>(std::move(keys));
+            auto lhs = _meval(x.lhs);
+            return [lhs, set](const std::vector<std::string> &, const std::vector<double> &v) { return set->has(lhs(v)); };
+        }
+
+        retFnT operator()(strIn const& x) const {
+            std::vector<std::string> keys;
+            loadKeys(x.set, keys);
+            auto set = std::make_shared<const keySet<std::string>>(std::move(keys));
+            auto i = _seval.index(x.lhs);
+            if (i >= 0) {
+                return [i, set](const std::vector<std::string> &v, const std::vector<double> &) { return set->has(v[i]); };
+            }
+            auto lhs = _seval(x.lhs);
+            return [lhs, set](const std::vector<std::string> &v, const std::vector<double> &) { return set->has(lhs(v)); };
+        }
+
+        retFnT operator()(strMatch const& x) const {
+            auto pat = std::make_shared<const pattern>(x.operator_, x.pattern);
+            auto i = _seval.index(x.lhs);
+            if (i >= 0) {
+                return [i, pat](const std::vector<std::string> &v, const std::vector<double> &) { return pat->matches(v[i]); };
+            }
+            auto lhs = _seval(x.lhs);
+            return [lhs, pat](const std::vector<std::string> &v, const std::vector<double> &) { return pat->matches(lhs(v)); };
+        }
+
         retFnT operator()(expr const& x) const {
           return boost::apply_visitor(*this, x);
         }
@@ -199,4 +507,23 @@ BOOST_FUSION_ADAPT_STRUCT(
     (client::str::ast::expr, rhs)
 )
 
+BOOST_FUSION_ADAPT_STRUCT(
+    client::relational::ast::mathIn,
+    (client::math::ast::expr, lhs)
+    (client::relational::ast::mathSet, set)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::relational::ast::strIn,
+    (client::str::ast::expr, lhs)
+    (client::relational::ast::strSet, set)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    client::relational::ast::strMatch,
+    (client::str::ast::expr, lhs)
+    (client::relational::ast::matchtoken, operator_)
+    (std::string, pattern)
+)
+
 #endif
@@ -24,9 +24,14 @@ namespace client { namespace relational { namespace parser
         expression(error_handler<Iterator>& error_handler);
 
         qi::rule<Iterator, ast::expr(), ascii::space_type> expr;
+        qi::rule<Iterator, std::string(), ascii::space_type> quoted;
+        qi::rule<Iterator, ast::inFile(), ascii::space_type> inFile;
+        qi::rule<Iterator, ast::mathSet(), ascii::space_type> mathSet;
+        qi::rule<Iterator, ast::strSet(), ascii::space_type> strSet;
         client::math::parser::expression<Iterator> mathExpr;
         client::str::parser::expression<Iterator> strExpr;
         qi::symbols<char, ast::optoken> relational_op;
+        qi::symbols<char, ast::matchtoken> match_op;
     };
 }}}
 
@@ -1,6 +1,8 @@
 #include "rexpr.hpp"
 //#include "error_handler.hpp"
 #include <boost/spirit/include/phoenix_function.hpp>
+#include <boost/spirit/include/phoenix_operator.hpp>
+#include <boost/spirit/include/phoenix_bind.hpp>
 
 namespace client { namespace relational { namespace parser
 {
@@ -22,6 +24,7 @@ namespace client { namespace relational { namespace parser
         qi::alnum_type alnum;
         qi::bool_type bool_;
         qi::double_type double_;
+        qi::lit_type lit;
 
         using qi::on_error;
         using qi::on_success;
@@ -40,13 +43,33 @@ namespace client { namespace relational { namespace parser
             (">=", ast::optoken::greater_equal)
             ;
 
-        expr = (mathExpr >> relational_op >> mathExpr)
+        match_op.add
+            ("like", ast::matchtoken::like)
+            ("~", ast::matchtoken::regex)
+            ;
+
+        quoted = lexeme['"' >> *(char_ - '"') >> '"'];
+
+        inFile = lit("file") >> quoted[boost::phoenix::bind(&ast::inFile::name, _val) = _1];
+
+        mathSet = inFile | ('(' >> (double_ % ',') >> ')');
+
+        strSet = inFile | ('(' >> (quoted % ',') >> ')');
+
+        expr = (mathExpr >> lit("in") >> mathSet)
+             | (strExpr >> lit("in") >> strSet)
+             | (strExpr >> match_op >> quoted)
+             | (mathExpr >> relational_op >> mathExpr)
              | (strExpr >> relational_op >> strExpr);
 
         ///////////////////////////////////////////////////////////////////////
         // Debugging and error handling and reporting support.
         BOOST_SPIRIT_DEBUG_NODES(
             (expr)
+            (quoted)
+            (inFile)
+            (mathSet)
+            (strSet)
         );
 
         ///////////////////////////////////////////////////////////////////////
@@ -9,6 +9,7 @@
 
 #include <boost/config/warning_disable.hpp>
 #include <boost/variant/recursive_variant.hpp>
+#include <boost/variant/get.hpp>
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <boost/fusion/include/io.hpp>
 #include <boost/optional.hpp>
@@ -41,6 +42,28 @@ namespace client { namespace str { namespace ast
         }
     };
 
+    // variables and columns an expression refers to
+    struct depsEval {
+    private:
+      using ColIndices = client::helper::ColIndices;
+    public:
+      using result_type = ColIndices;
+      result_type operator()(variable const &x) const {
+        ColIndices res;
+        res.varStr.push_back(x);
+        return res;
+      }
+      result_type operator()(column const &x) const {
+        ColIndices res;
+        res.str.push_back(x);
+        return res;
+      }
+      result_type operator()(quoted const &x) const { return result_type{}; }
+      result_type operator()(expr const& e) const {
+        return boost::apply_visitor(*this, e);
+      }
+    };
+
     struct colsEval {
     private:
       using ColIndices = client::helper::ColIndices;
@@ -119,6 +142,14 @@ namespace client { namespace str { namespace ast
         retFnT operator()(expr const& x) const {
           return boost::apply_visitor(*this, x);
         }
+
+        // position of the column in the row, -1 if it is not a column
+        int index(expr const& x) const {
+          if (auto c = boost::get<column>(&x)) return _index.str(*c);
+          auto v = boost::get<variable>(&x);
+          if (!v || _global.gVarsS.count(*v)) return -1;
+          return _index.varStr(*v);
+        }
     };
 }}}
 
@@ -0,0 +1,312 @@
+#if !defined(PAWN_SKETCH)
+#define PAWN_SKETCH
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// mergeable summaries for the approximate aggregates of reduce. A summary is
+// laid out in a run of the doubles of the reduce state so that it is copied,
+// sent to the other processes and merged like the state of any aggregate.
+namespace client { namespace sketch {
+
+// splitmix64 finalizer, spreads a hash of poor quality over all the bits
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+inline uint64_t hash(const std::string &s) { return mix(std::hash<std::string>{}(s)); }
+
+inline uint64_t hash(double d) {
+  if (d == 0) d = 0;  // -0 and 0 are the same value
+  uint64_t h;
+  std::memcpy(&h, &d, sizeof(h));
+  return mix(h);
+}
+
+// HyperLogLog with 2^11 registers, a relative error of about 2.3%. A
+// register is a byte, six of them are packed in the integer part of a
+// double which is exact up to 2^53.
+namespace hll {
+constexpr int precision = 11;
+constexpr size_t registers = size_t(1) << precision;
+constexpr size_t perCell = 6;
+constexpr size_t width = (registers + perCell - 1) / perCell;
+
+// the register and the rank of the hash as a single number
+inline double code(uint64_t h) {
+  auto reg = h >> (64 - precision);
+  auto rest = (h << precision) | (uint64_t(1) << (precision - 1));
+  return double(reg * 64 + __builtin_clzll(rest) + 1);
+}
+
+inline unsigned get(const double *state, size_t reg) {
+  return (uint64_t(state[reg / perCell]) >> (8 * (reg % perCell))) & 0xff;
+}
+
+inline void add(double *state, double code) {
+  auto c = uint64_t(code);
+  auto reg = c / 64;
+  auto rank = c % 64;
+  auto cur = get(state, reg);
+  if (rank <= cur) return;
+  state[reg / perCell] += double((rank - cur) << (8 * (reg % perCell)));
+}
+
+inline void merge(double *state, const double *other) {
+  for (size_t i = 0; i < width; ++i) {
+    auto a = uint64_t(state[i]);
+    auto b = uint64_t(other[i]);
+    if (a == b || b == 0) continue;
+    uint64_t res = 0;
+    for (size_t j = 0; j < perCell; ++j) {
+      auto shift = 8 * j;
+      res |= std::max((a >> shift) & 0xff, (b >> shift) & 0xff) << shift;
+    }
+    state[i] = double(res);
+  }
+}
+
+inline double estimate(const double *state) {
+  constexpr double m = double(registers);
+  double sum = 0;
+  size_t zeros = 0;
+  for (size_t i = 0; i < registers; ++i) {
+    auto r = get(state, i);
+    sum += std::ldexp(1.0, -int(r));
+    if (r == 0) ++zeros;
+  }
+  auto e = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  // linear counting is more accurate while many registers are empty
+  if (e <= 2.5 * m && zeros > 0) e = m * std::log(m / double(zeros));
+  return std::round(e);
+}
+} // namespace hll
+
+// merging t-digest with room for 128 centroids and 128 values that are
+// added in a buffer and compressed into the centroids when it is full. The
+// state is the count of centroids, the count of buffered values, the min,
+// the max, the mean and the weight of each centroid and the buffer.
+namespace tdigest {
+constexpr size_t centroids = 128;
+constexpr size_t buffer = 128;
+constexpr double compression = 100;
+constexpr size_t width = 4 + 2 * centroids + buffer;
+
+using centroidsT = std::vector<std::pair<double, double>>;
+
+inline void collect(const double *state, centroidsT &out) {
+  auto nc = size_t(state[0]);
+  auto nb = size_t(state[1]);
+  for (size_t i = 0; i < nc; ++i) out.emplace_back(state[4 + 2 * i], state[5 + 2 * i]);
+  for (size_t i = 0; i < nb; ++i) out.emplace_back(state[4 + 2 * centroids + i], 1.0);
+}
+
+// merges neighbouring centroids as long as they fit in a unit of the k1
+// scale, fine at the tails and coarse in the middle
+inline centroidsT compress(centroidsT c, double delta = compression) {
+  if (c.empty()) return c;
+  std::sort(begin(c), end(c));
+  double total = 0;
+  for (const auto &it : c) total += it.second;
+  constexpr double pi = 3.14159265358979323846;
+  auto k = [delta](double q) { return delta / (2 * pi) * std::asin(2 * q - 1); };
+  auto kInv = [delta](double k) { return (std::sin(k * 2 * pi / delta) + 1) / 2; };
+  centroidsT res;
+  auto cur = c[0];
+  double before = 0;
+  auto limit = kInv(k(0) + 1);
+  for (size_t i = 1; i < c.size(); ++i) {
+    if ((before + cur.second + c[i].second) / total <= limit) {
+      auto w = cur.second + c[i].second;
+      cur.first += (c[i].first - cur.first) * c[i].second / w;
+      cur.second = w;
+      continue;
+    }
+    res.push_back(cur);
+    before += cur.second;
+    limit = kInv(k(std::min(before / total, 1.0)) + 1);
+    cur = c[i];
+  }
+  res.push_back(cur);
+  if (res.size() > centroids) return compress(std::move(res), delta / 2);
+  return res;
+}
+
+inline void store(double *state, const centroidsT &c) {
+  state[0] = double(c.size());
+  state[1] = 0;
+  for (size_t i = 0; i < c.size(); ++i) {
+    state[4 + 2 * i] = c[i].first;
+    state[5 + 2 * i] = c[i].second;
+  }
+}
+
+inline bool empty(const double *state) { return state[0] == 0 && state[1] == 0; }
+
+inline void add(double *state, double x) {
+  if (empty(state)) {
+    state[2] = state[3] = x;
+  } else {
+    state[2] = std::min(state[2], x);
+    state[3] = std::max(state[3], x);
+  }
+  auto nb = size_t(state[1]);
+  state[4 + 2 * centroids + nb] = x;
+  state[1] = double(nb + 1);
+  if (nb + 1 < buffer) return;
+  centroidsT c;
+  collect(state, c);
+  store(state, compress(std::move(c)));
+}
+
+inline void merge(double *state, const double *other) {
+  if (empty(other)) return;
+  if (empty(state)) {
+    state[2] = other[2];
+    state[3] = other[3];
+  } else {
+    state[2] = std::min(state[2], other[2]);
+    state[3] = std::max(state[3], other[3]);
+  }
+  centroidsT c;
+  collect(state, c);
+  collect(other, c);
+  store(state, compress(std::move(c)));
+}
+
+// interpolates between the centers of the centroids, and with the min and
+// the max beyond the first and the last
+inline double quantile(const double *state, double q) {
+  if (empty(state)) return std::nan("");
+  centroidsT c;
+  collect(state, c);
+  c = compress(std::move(c));
+  auto lo = state[2];
+  auto hi = state[3];
+  double total = 0;
+  for (const auto &it : c) total += it.second;
+  auto target = q * total;
+  if (target <= c.front().second / 2) {
+    if (c.front().second <= 1) return c.front().first;
+    return lo + (c.front().first - lo) * target / (c.front().second / 2);
+  }
+  if (target >= total - c.back().second / 2) {
+    if (c.back().second <= 1) return c.back().first;
+    return hi - (hi - c.back().first) * (total - target) / (c.back().second / 2);
+  }
+  auto cum = c.front().second / 2;
+  for (size_t i = 0; i + 1 < c.size(); ++i) {
+    auto dw = (c[i].second + c[i + 1].second) / 2;
+    if (cum + dw >= target) return c[i].first + (c[i + 1].first - c[i].first) * (target - cum) / dw;
+    cum += dw;
+  }
+  return hi;
+}
+} // namespace tdigest
+
+// histograms of n bins. With a range the bins are of equal width over
+// [lo, hi) and the values below and above it are counted in the first and
+// the last bin, the state is the count of each bin. Without a range the bins
+// adapt to the values as in the streaming histogram of Ben-Haim and Tom-Tov,
+// the state is the count of bins in use and the center and the count of each
+// with room for one more, a value is a bin of its own and the two bins with
+// the closest centers are merged while there are more than n.
+namespace hist {
+inline size_t width(size_t n) { return 1 + 2 * (n + 1); }
+
+inline void add(double *state, size_t n, double lo, double hi, double x) {
+  auto b = std::floor((x - lo) / (hi - lo) * double(n));
+  if (b >= double(n)) b = double(n - 1);
+  if (!(b > 0)) b = 0;
+  state[size_t(b)] += 1.0;
+}
+
+using binsT = std::vector<std::pair<double, double>>;
+
+inline void collect(const double *state, binsT &out) {
+  auto used = size_t(state[0]);
+  for (size_t i = 0; i < used; ++i) out.emplace_back(state[1 + 2 * i], state[2 + 2 * i]);
+}
+
+// sorted bins with distinct centers to at most n bins
+inline void shrink(binsT &b, size_t n) {
+  while (b.size() > n) {
+    size_t at = 0;
+    for (size_t i = 1; i + 1 < b.size(); ++i) {
+      if (b[i + 1].first - b[i].first < b[at + 1].first - b[at].first) at = i;
+    }
+    auto w = b[at].second + b[at + 1].second;
+    b[at].first = (b[at].first * b[at].second + b[at + 1].first * b[at + 1].second) / w;
+    b[at].second = w;
+    b.erase(begin(b) + at + 1);
+  }
+}
+
+inline void store(double *state, const binsT &b) {
+  state[0] = double(b.size());
+  for (size_t i = 0; i < b.size(); ++i) {
+    state[1 + 2 * i] = b[i].first;
+    state[2 + 2 * i] = b[i].second;
+  }
+}
+
+inline void add(double *state, size_t n, double x) {
+  auto used = size_t(state[0]);
+  size_t i = 0;
+  while (i < used && state[1 + 2 * i] < x) ++i;
+  if (i < used && state[1 + 2 * i] == x) {
+    state[2 + 2 * i] += 1.0;
+    return;
+  }
+  for (auto j = used; j > i; --j) {
+    state[1 + 2 * j] = state[2 * j - 1];
+    state[2 + 2 * j] = state[2 * j];
+  }
+  state[1 + 2 * i] = x;
+  state[2 + 2 * i] = 1.0;
+  state[0] = double(used + 1);
+  if (used + 1 <= n) return;
+  binsT b;
+  collect(state, b);
+  shrink(b, n);
+  store(state, b);
+}
+
+inline void merge(double *state, const double *other, size_t n) {
+  if (other[0] == 0) return;
+  binsT all;
+  collect(state, all);
+  collect(other, all);
+  std::sort(begin(all), end(all));
+  binsT b;
+  for (const auto &it : all) {
+    if (!b.empty() && b.back().first == it.first) b.back().second += it.second;
+    else b.push_back(it);
+  }
+  shrink(b, n);
+  store(state, b);
+}
+
+inline double center(const double *state, size_t i) {
+  return i < size_t(state[0]) ? state[1 + 2 * i] : std::nan("");
+}
+
+inline double count(const double *state, size_t i) {
+  return i < size_t(state[0]) ? state[2 + 2 * i] : 0.0;
+}
+} // namespace hist
+
+}}
+
+#endif
@@ -0,0 +1,236 @@
+/*!
+ * @file
+ * class SortPawn and RangePartition, units for a parallel sample sort of
+ * the rows on a numeric column or on string columns.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef SORTPAWN_EZL_H
+#define SORTPAWN_EZL_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/mpi.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <ezl/helper/Karta.hpp>
+#include <ezl/helper/Par.hpp>
+#include <ezl/pipeline/Dest.hpp>
+#include <ezl/pipeline/Source.hpp>
+
+#include <pawnTag.hpp>
+
+namespace ezl {
+
+/*!
+ * order of the sort keys, NaN goes last in either direction.
+ * */
+template <class K> struct SortOrder {
+  bool desc;
+  bool operator()(const K &a, const K &b) const { return desc ? b < a : a < b; }
+};
+
+template <> struct SortOrder<double> {
+  bool desc;
+  bool operator()(double a, double b) const {
+    if (std::isnan(a)) return false;
+    if (std::isnan(b)) return true;
+    return desc ? b < a : a < b;
+  }
+};
+
+/*!
+ * partitioner for the rows after a `SortPawn` with splitters, the bucket
+ * of a row is the count of splitters that are not after its key. The
+ * splitters are filled in by the sort before the first row comes.
+ *
+ * A key that is equal to a splitter can go in any of the buckets from the
+ * one that ends with the splitter to the one after the last such splitter
+ * without breaking the order of the buckets. A key with many rows is picked
+ * as a splitter many times, its rows are dealt out in turn over all these
+ * buckets instead of filling up one of them. So the rows of a key can be on
+ * more than one process, nothing after the sort is to expect a key on a
+ * single one. The count of the rows dealt is of each copy of the
+ * partitioner, the call is not const.
+ * */
+template <class K> struct RangePartition {
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+  std::shared_ptr<const std::vector<K>> splitters;
+  std::function<K(const std::vector<std::string>&, const std::vector<double>&)> key;
+  bool desc;
+  size_t dealt{0};
+  size_t operator()(const rowT &row) {
+    auto k = key(std::get<0>(row), std::get<1>(row));
+    SortOrder<K> order{desc};
+    auto first = begin(*splitters);
+    auto lo = std::lower_bound(first, end(*splitters), k, order) - first;
+    auto hi = std::upper_bound(first + lo, end(*splitters), k, order) - first;
+    if (lo == hi) return hi;
+    return lo + dealt++ % (hi - lo + 1);
+  }
+};
+
+/*!
+ * @ingroup units
+ * Keeps the rows and passes them on sorted on the key at the end of data.
+ *
+ * With splitters it is the first step of a sample sort. The processes of
+ * the prior unit send evenly spaced keys of their sorted rows to the first
+ * of them which picks a splitter for each of the buckets but the last and
+ * sends these back. A `RangePartition` after it can then send each bucket
+ * to a process of its own, which sorts the rows it gets with another
+ * `SortPawn`. Equal keys that are splitters can be in more than one bucket.
+ *
+ * It is not a `Link` since it needs the `Par` that is forwarded to it, the
+ * samples are exchanged over the processes the prior task runs in.
+ * */
+template <class K>
+class SortPawn
+    : public Dest<std::tuple<const std::vector<std::string>&, const std::vector<double>&>>,
+      public Source<std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+  using keyT = std::function<K(const std::vector<std::string>&, const std::vector<double>&)>;
+
+  // samples sent by a process for each bucket
+  static constexpr size_t oversample = 32;
+
+  SortPawn(keyT key, bool desc, size_t buckets = 0,
+           std::shared_ptr<std::vector<K>> splitters = nullptr)
+      : _key{std::move(key)}, _desc{desc}, _buckets{buckets},
+        _splitters{std::move(splitters)}, _tag{_splitters ? pawnTag() : 0} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    const auto &s = std::get<0>(data);
+    const auto &v = std::get<1>(data);
+    _rows.push_back(Entry{_key(s, v), s, v});
+  }
+
+  virtual void forwardPar(const Par *pr) override final {
+    if (_visited) return;
+    _visited = true;
+    if (pr) {
+      _par = *pr;
+      _hasPar = true;
+    }
+    for (auto &it : this->next()) {
+      it.second->forwardPar(pr);
+    }
+    _visited = false;
+  }
+
+  virtual void signalEvent(int i) override final {
+    if (_visited) return;
+    _visited = true;
+    if (i == 0) this->incSig();
+    else if (this->decSig() == 0) _dataEnd();
+    for (auto &it : this->next()) {
+      it.second->signalEvent(i);
+    }
+    _visited = false;
+  }
+
+  virtual std::vector<Task *> root() override final {
+    std::vector<Task *> roots;
+    if (_traversingRoots) return roots;
+    _traversingRoots = true;
+    for (auto &it : this->prev()) {
+      auto temp = it.second->root();
+      roots.insert(std::begin(roots), std::begin(temp), std::end(temp));
+    }
+    _traversingRoots = false;
+    return roots;
+  }
+
+  virtual std::vector<Task *> forwardTasks() override final {
+    std::vector<Task *> tasks;
+    if (_traversingTasks) return tasks;
+    _traversingTasks = true;
+    for (auto &it : this->next()) {
+      auto temp = it.second->forwardTasks();
+      tasks.insert(std::end(tasks), std::begin(temp), std::end(temp));
+    }
+    _traversingTasks = false;
+    return tasks;
+  }
+
+private:
+  struct Entry {
+    K key;
+    std::vector<std::string> s;
+    std::vector<double> v;
+  };
+
+  void _dataEnd() {
+    auto rows = std::move(_rows);
+    _rows.clear();
+    SortOrder<K> order{_desc};
+    std::sort(begin(rows), end(rows), [&order](const Entry &a, const Entry &b) {
+      return order(a.key, b.key);
+    });
+    if (_splitters) _split(rows);
+    for (const auto &row : rows) {
+      rowT res{row.s, row.v};
+      for (auto &it : this->next()) {
+        it.second->dataEvent(res);
+      }
+    }
+  }
+
+  void _split(const std::vector<Entry> &rows) {
+    _splitters->clear();
+    if (!_hasPar || !_par.inRange() || _buckets < 2) return;
+    std::vector<K> samples;
+    auto m = std::min(rows.size(), oversample * _buckets);
+    for (size_t i = 0; i < m; ++i) samples.push_back(rows[(2 * i + 1) * rows.size() / (2 * m)].key);
+    auto comm = Karta::inst().comm();
+    auto n = _par.nProc();
+    if (_par.pos() != 0) {
+      comm.send(_par[0], _tag, samples);
+      comm.recv(_par[0], _tag, *_splitters);
+      return;
+    }
+    for (int i = 1; i < n; ++i) {
+      std::vector<K> other;
+      comm.recv(_par[i], _tag, other);
+      std::move(begin(other), end(other), std::back_inserter(samples));
+    }
+    std::sort(begin(samples), end(samples), SortOrder<K>{_desc});
+    if (!samples.empty()) {
+      for (size_t i = 1; i < _buckets; ++i) {
+        _splitters->push_back(samples[i * samples.size() / _buckets]);
+      }
+    }
+    for (int i = 1; i < n; ++i) {
+      comm.send(_par[i], _tag, *_splitters);
+    }
+  }
+
+  keyT _key;
+  bool _desc;
+  size_t _buckets;
+  std::shared_ptr<std::vector<K>> _splitters;
+  int _tag;
+  std::vector<Entry> _rows;
+  Par _par;
+  bool _hasPar{false};
+  bool _visited{false};
+  bool _traversingRoots{false};
+  bool _traversingTasks{false};
+};
+} // namespace ezl
+
+#endif // !SORTPAWN_EZL_H
@@ -0,0 +1,214 @@
+/*!
+ * @file
+ * class TopPawn and HeavyHittersPawn, units for the rows with the least or
+ * the greatest value of a column and for the most frequent keys.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef TOPPAWN_EZL_H
+#define TOPPAWN_EZL_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <ezl/pipeline/Link.hpp>
+
+namespace ezl {
+
+/*!
+ * @ingroup units
+ * Keeps the first n rows in the order of a numeric column in a bounded heap
+ * and passes them on in that order at the end of data. Placed once in each
+ * process and once more where the rows of all of them are sent, so that
+ * only n rows of a process cross over. Rows with a NaN value are dropped.
+ * */
+class TopPawn
+    : public Link<std::tuple<const std::vector<std::string>&, const std::vector<double>&>,
+                  std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+  using entryT = std::pair<std::vector<std::string>, std::vector<double>>;
+
+  TopPawn(size_t n, int pos, bool desc) : _n{n}, _pos{pos}, _desc{desc} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    const auto &v = std::get<1>(data);
+    if (_n == 0 || std::isnan(v[_pos])) return;
+    if (_rows.size() == _n) {
+      if (!_before(v, _rows.front().second)) return;
+      std::pop_heap(begin(_rows), end(_rows), _cmp());
+      _rows.pop_back();
+    }
+    _rows.emplace_back(std::get<0>(data), v);
+    std::push_heap(begin(_rows), end(_rows), _cmp());
+  }
+
+private:
+  bool _before(const std::vector<double> &a, const std::vector<double> &b) const {
+    return _desc ? a[_pos] > b[_pos] : a[_pos] < b[_pos];
+  }
+
+  // the heap has the last of the kept rows on the top
+  struct Cmp {
+    const TopPawn *t;
+    bool operator()(const entryT &a, const entryT &b) const { return t->_before(a.second, b.second); }
+  };
+  Cmp _cmp() const { return Cmp{this}; }
+
+  virtual void _dataEnd(int) override final {
+    auto rows = std::move(_rows);
+    _rows.clear();
+    std::sort_heap(begin(rows), end(rows), _cmp());
+    for (const auto &row : rows) {
+      rowT res{row.first, row.second};
+      for (auto &it : this->next()) {
+        it.second->dataEvent(res);
+      }
+    }
+  }
+
+  size_t _n;
+  int _pos;
+  bool _desc;
+  std::vector<entryT> _rows;
+};
+
+/*!
+ * @ingroup units
+ * Space-Saving summary of the most frequent string keys of the rows, with a
+ * fixed number of counters. A key that is not counted takes over the counter
+ * with the least count and its error. The counts are exact as long as there
+ * are no more keys than counters, otherwise a count is over by at most its
+ * error.
+ *
+ * The rows out are the key with the count and the error. With `isMerge` the
+ * rows in are such rows from the summaries of other processes that are
+ * added in with their counts. At the end of data the n keys with the largest
+ * counts are passed on.
+ * */
+class HeavyHittersPawn
+    : public Link<std::tuple<const std::vector<std::string>&, const std::vector<double>&>,
+                  std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+
+  HeavyHittersPawn(size_t capacity, size_t n, bool isMerge)
+      : _capacity{std::max(capacity, size_t(1))}, _n{n}, _isMerge{isMerge} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    const auto &key = std::get<0>(data);
+    double w = 1, e = 0;
+    if (_isMerge) {
+      w = std::get<1>(data)[0];
+      e = std::get<1>(data)[1];
+    }
+    auto it = _pos.find(key);
+    if (it != std::end(_pos)) {
+      auto &c = _counters[it->second];
+      c.count += w;
+      c.err += e;
+      _siftDown(_at[it->second]);
+      return;
+    }
+    if (_counters.size() < _capacity) {
+      auto i = _counters.size();
+      _counters.push_back(Counter{key, w, e});
+      _pos.emplace(key, i);
+      _heap.push_back(i);
+      _at.push_back(i);
+      _siftUp(i);
+      return;
+    }
+    // the key replaces the least counted one, which it may have been
+    auto i = _heap[0];
+    auto &c = _counters[i];
+    _pos.erase(c.key);
+    c.err = c.count + e;
+    c.count += w;
+    c.key = key;
+    _pos.emplace(key, i);
+    _siftDown(0);
+  }
+
+private:
+  struct Counter {
+    std::vector<std::string> key;
+    double count;
+    double err;
+  };
+
+  // min heap of the counters by count, _at is the heap position of a counter
+  bool _less(size_t i, size_t j) const {
+    return _counters[_heap[i]].count < _counters[_heap[j]].count;
+  }
+
+  void _swap(size_t i, size_t j) {
+    std::swap(_heap[i], _heap[j]);
+    _at[_heap[i]] = i;
+    _at[_heap[j]] = j;
+  }
+
+  void _siftUp(size_t i) {
+    while (i > 0 && _less(i, (i - 1) / 2)) {
+      _swap(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  void _siftDown(size_t i) {
+    for (;;) {
+      auto l = 2 * i + 1;
+      if (l >= _heap.size()) return;
+      auto m = (l + 1 < _heap.size() && _less(l + 1, l)) ? l + 1 : l;
+      if (!_less(m, i)) return;
+      _swap(i, m);
+      i = m;
+    }
+  }
+
+  virtual void _dataEnd(int) override final {
+    auto counters = std::move(_counters);
+    _counters.clear();
+    _pos.clear();
+    _heap.clear();
+    _at.clear();
+    auto n = std::min(_n, counters.size());
+    std::partial_sort(begin(counters), begin(counters) + n, end(counters),
+                      [](const Counter &a, const Counter &b) {
+      if (a.count != b.count) return a.count > b.count;
+      return a.err < b.err;
+    });
+    for (size_t i = 0; i < n; ++i) {
+      std::vector<double> v{counters[i].count, counters[i].err};
+      rowT res{counters[i].key, v};
+      for (auto &it : this->next()) {
+        it.second->dataEvent(res);
+      }
+    }
+  }
+
+  size_t _capacity;
+  size_t _n;
+  bool _isMerge;
+  std::vector<Counter> _counters;
+  std::unordered_map<std::vector<std::string>, size_t,
+                     boost::hash<std::vector<std::string>>> _pos;
+  std::vector<size_t> _heap;
+  std::vector<size_t> _at;
+};
+} // namespace ezl
+
+#endif // !TOPPAWN_EZL_H
@@ -0,0 +1,153 @@
+/*!
+ * @file
+ * class TreeReducePawn, unit for combining the keyless partial aggregates of
+ * the processes in a binomial tree.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef TREEREDUCEPAWN_EZL_H
+#define TREEREDUCEPAWN_EZL_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/mpi.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <ezl/helper/Karta.hpp>
+#include <ezl/helper/Par.hpp>
+#include <ezl/pipeline/Dest.hpp>
+#include <ezl/pipeline/Source.hpp>
+
+#include <pawnTag.hpp>
+
+namespace ezl {
+
+/*!
+ * @ingroup units
+ * Runs in the processes of the prior unit and takes the single row of the
+ * keyless partial reduce in each of them. At the end of data the rows are
+ * merged pairwise in a binomial tree over the processes, log P rounds of
+ * point to point messages, and the first process of the prior unit passes
+ * the combined row to the next units.
+ *
+ * It is not a `Link` since it needs the `Par` that is forwarded to it, the
+ * tree is over the processes the prior task runs in.
+ * */
+class TreeReducePawn
+    : public Dest<std::tuple<const std::vector<std::string>&, const std::vector<double>&>>,
+      public Source<std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+  // merges the partial aggregates of the second into the first
+  using mergeT = std::function<void(std::vector<double>&, const std::vector<double>&)>;
+
+  TreeReducePawn(mergeT merge) : _merge{std::move(merge)}, _tag{pawnTag()} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    if (_val.empty()) {
+      _val = std::get<1>(data);
+    } else {
+      _merge(_val, std::get<1>(data));
+    }
+  }
+
+  virtual void forwardPar(const Par *pr) override final {
+    if (_visited) return;
+    _visited = true;
+    if (pr) {
+      _par = *pr;
+      _hasPar = true;
+    }
+    for (auto &it : this->next()) {
+      it.second->forwardPar(pr);
+    }
+    _visited = false;
+  }
+
+  virtual void signalEvent(int i) override final {
+    if (_visited) return;
+    _visited = true;
+    if (i == 0) this->incSig();
+    else if (this->decSig() == 0) _dataEnd();
+    for (auto &it : this->next()) {
+      it.second->signalEvent(i);
+    }
+    _visited = false;
+  }
+
+  virtual std::vector<Task *> root() override final {
+    std::vector<Task *> roots;
+    if (_traversingRoots) return roots;
+    _traversingRoots = true;
+    for (auto &it : this->prev()) {
+      auto temp = it.second->root();
+      roots.insert(std::begin(roots), std::begin(temp), std::end(temp));
+    }
+    _traversingRoots = false;
+    return roots;
+  }
+
+  virtual std::vector<Task *> forwardTasks() override final {
+    std::vector<Task *> tasks;
+    if (_traversingTasks) return tasks;
+    _traversingTasks = true;
+    for (auto &it : this->next()) {
+      auto temp = it.second->forwardTasks();
+      tasks.insert(std::end(tasks), std::begin(temp), std::end(temp));
+    }
+    _traversingTasks = false;
+    return tasks;
+  }
+
+private:
+  // an empty vector stands for no rows since the partial row always has a
+  // value for each aggregate
+  void _dataEnd() {
+    auto val = std::move(_val);
+    _val.clear();
+    if (!_hasPar || !_par.inRange()) return;
+    auto comm = Karta::inst().comm();
+    auto n = _par.nProc();
+    auto pos = _par.pos();
+    for (int step = 1; step < n; step <<= 1) {
+      if (pos & step) {
+        comm.send(_par[pos - step], _tag, val);
+        return;
+      }
+      if (pos + step < n) {
+        std::vector<double> other;
+        comm.recv(_par[pos + step], _tag, other);
+        if (val.empty()) val = std::move(other);
+        else if (!other.empty()) _merge(val, other);
+      }
+    }
+    if (val.empty()) return;
+    rowT row{_key, val};
+    for (auto &it : this->next()) {
+      it.second->dataEvent(row);
+    }
+  }
+
+  mergeT _merge;
+  int _tag;
+  std::vector<double> _val;
+  const std::vector<std::string> _key{};
+  Par _par;
+  bool _hasPar{false};
+  bool _visited{false};
+  bool _traversingRoots{false};
+  bool _traversingTasks{false};
+};
+} // namespace ezl
+
+#endif // !TREEREDUCEPAWN_EZL_H
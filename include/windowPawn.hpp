@@ -0,0 +1,153 @@
+/*!
+ * @file
+ * class WindowPawn, unit for moving aggregates over the last rows.
+ *
+ * This file is a part of easyLambda(ezl) project for parallel data
+ * processing with modern C++ and MPI.
+ *
+ * @copyright Utkarsh Bhardwaj <haptork@gmail.com> 2015-2016
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying LICENSE.md or copy at * http://boost.org/LICENSE_1_0.txt)
+ * */
+
+#ifndef WINDOWPAWN_EZL_H
+#define WINDOWPAWN_EZL_H
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <ezl/pipeline/Link.hpp>
+
+namespace ezl {
+
+/*!
+ * @ingroup units
+ * Appends to each row the aggregates of numeric columns over the last n
+ * rows, or the last n rows with the same keys, in the order the rows come
+ * in. The first rows of a key have the aggregates of the rows so far.
+ *
+ * Each aggregate is updated in constant time per row. The values in the
+ * window are kept in a ring, a sum adds the new value and takes out the one
+ * that leaves and is summed afresh from the ring every n rows so that the
+ * rounding does not pile up. A min or max keeps a deque of the values that
+ * can still be the extreme, each of them is pushed and popped once. The
+ * aggregate is NaN as long as there is a NaN in the window.
+ * */
+class WindowPawn
+    : public Link<std::tuple<const std::vector<std::string>&, const std::vector<double>&>,
+                  std::tuple<const std::vector<std::string>&, const std::vector<double>&>> {
+public:
+  using rowT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
+  enum class Op : int { sum, avg, min, max };
+
+  // aggs are the aggregates with the position of their column
+  WindowPawn(size_t n, std::vector<int> keys, std::vector<std::pair<Op, int>> aggs)
+      : _n{std::max(n, size_t(1))}, _keys{std::move(keys)}, _aggs{std::move(aggs)} {}
+
+  virtual void dataEvent(const rowT &data) override final {
+    const auto &s = std::get<0>(data);
+    const auto &v = std::get<1>(data);
+    auto &st = _state(s);
+    auto slot = st.seen % _n;
+    auto full = st.seen >= _n;
+    auto count = double(std::min(st.seen + 1, _n));
+    _out = v;
+    for (size_t i = 0; i < _aggs.size(); ++i) {
+      auto x = v[_aggs[i].second];
+      auto &cell = st.ring[i * _n + slot];
+      if (full) {
+        if (std::isnan(cell)) --st.nans[i];
+        else st.sums[i] -= cell;
+      }
+      cell = x;
+      if (std::isnan(x)) ++st.nans[i];
+      else st.sums[i] += x;
+      auto op = _aggs[i].first;
+      if (op == Op::min || op == Op::max) _push(st.extremes[i], st.seen, x, op == Op::max);
+      if (st.nans[i] > 0) {
+        _out.push_back(std::nan(""));
+        continue;
+      }
+      switch (op) {
+        case Op::sum: _out.push_back(st.sums[i]); break;
+        case Op::avg: _out.push_back(st.sums[i] / count); break;
+        default: _out.push_back(st.extremes[i].front().second);
+      }
+    }
+    if (slot == _n - 1) _resum(st);
+    ++st.seen;
+    rowT res{s, _out};
+    for (auto &it : this->next()) {
+      it.second->dataEvent(res);
+    }
+  }
+
+private:
+  struct State {
+    size_t seen{0};
+    std::vector<double> ring;
+    std::vector<double> sums;
+    std::vector<size_t> nans;
+    std::vector<std::deque<std::pair<size_t, double>>> extremes;
+  };
+
+  State &_state(const std::vector<std::string> &s) {
+    State *st = &_all;
+    if (!_keys.empty()) {
+      _key.clear();
+      for (auto i : _keys) _key.push_back(s[i]);
+      st = &_byKey[_key];
+    }
+    if (st->ring.empty()) {
+      st->ring.resize(_n * _aggs.size());
+      st->sums.resize(_aggs.size());
+      st->nans.resize(_aggs.size());
+      st->extremes.resize(_aggs.size());
+    }
+    return *st;
+  }
+
+  // the values before x that are not beyond it can no longer be the extreme
+  void _push(std::deque<std::pair<size_t, double>> &d, size_t seq, double x, bool isMax) {
+    while (!d.empty() && d.front().first + _n <= seq) d.pop_front();
+    if (std::isnan(x)) return;
+    while (!d.empty() && (isMax ? d.back().second <= x : d.back().second >= x)) d.pop_back();
+    d.emplace_back(seq, x);
+  }
+
+  void _resum(State &st) {
+    for (size_t i = 0; i < _aggs.size(); ++i) {
+      double sum = 0;
+      for (size_t j = 0; j < _n; ++j) {
+        auto x = st.ring[i * _n + j];
+        if (!std::isnan(x)) sum += x;
+      }
+      st.sums[i] = sum;
+    }
+  }
+
+  virtual void _dataEnd(int) override final {
+    _all = State{};
+    _byKey.clear();
+  }
+
+  size_t _n;
+  std::vector<int> _keys;
+  std::vector<std::pair<Op, int>> _aggs;
+  State _all;
+  std::unordered_map<std::vector<std::string>, State,
+                     boost::hash<std::vector<std::string>>> _byKey;
+  std::vector<std::string> _key;
+  std::vector<double> _out;
+};
+} // namespace ezl
+
+#endif // !WINDOWPAWN_EZL_H
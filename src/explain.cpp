@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <boost/mpi.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <ezl/helper/Karta.hpp>
+
+#include <explain.hpp>
+
+client::helper::UnitStats *client::helper::Explain::add(std::string name,
+    std::vector<int> ranks, std::string shuffle) {
+  _units.emplace_back();
+  auto &u = _units.back();
+  u.name = std::move(name);
+  u.ranks = std::move(ranks);
+  u.shuffle = std::move(shuffle);
+  return _analyze ? &u : nullptr;
+}
+
+void client::helper::Explain::start() {
+  _begin = std::chrono::steady_clock::now();
+  _cpuBegin = std::clock();
+}
+
+void client::helper::Explain::stop() {
+  _wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - _begin).count();
+  _cpu = double(std::clock() - _cpuBegin) / CLOCKS_PER_SEC;
+}
+
+long long client::helper::rowBytes(const std::vector<std::string> &s, const std::vector<double> &v) {
+  long long res = v.size() * sizeof(double);
+  for (const auto &it : s) res += it.size();
+  return res;
+}
+
+std::string client::helper::keysText(const ColIndices &c) {
+  std::string res;
+  for (size_t i = 0; i < c.str.size(); ++i) {
+    if (!res.empty()) res += " ";
+    if (i < c.varStr.size() && c.varStr[i] != "-") res += "%" + c.varStr[i];
+    else res += "%" + std::to_string(c.str[i]);
+  }
+  return res;
+}
+
+namespace {
+std::string ranksText(const std::vector<int> &ranks) {
+  if (ranks.empty()) return "local";
+  std::string res = "ranks";
+  for (auto it : ranks) res += " " + std::to_string(it);
+  return res;
+}
+}
+
+void client::helper::Explain::print() const {
+  auto &karta = ezl::Karta::inst();
+  // per process counters are packed for a single gather on rank 0
+  const int fields = 6;
+  std::vector<double> local;
+  local.reserve(_units.size() * fields + 2);
+  for (const auto &it : _units) {
+    local.push_back(it.rowsIn);
+    local.push_back(it.rowsOut);
+    local.push_back(it.bytes);
+    local.push_back(it.wall);
+    local.push_back(double(it.tablePeak));
+    local.push_back(it.cpu);
+  }
+  local.push_back(_wall);
+  local.push_back(_cpu);
+  std::vector<std::vector<double>> all;
+  if (_analyze && karta.nProc() > 1) {
+    boost::mpi::gather(karta.comm(), local, all, 0);
+  } else {
+    all.push_back(local);
+  }
+  if (karta.rank() != 0) return;
+  std::ostringstream out;
+  out << "plan:\n";
+  auto i = 0;
+  for (const auto &it : _units) {
+    if (!it.shuffle.empty()) out << "      shuffle " << it.shuffle << '\n';
+    out << std::setw(4) << i << ": " << it.name << " [" << ranksText(it.ranks) << "]\n";
+    if (_analyze) {
+      double rowsIn = 0, rowsOut = 0, bytes = 0, wall = 0, peak = 0, cpu = 0;
+      for (const auto &jt : all) {
+        rowsIn += jt[i * fields];
+        rowsOut += jt[i * fields + 1];
+        bytes += jt[i * fields + 2];
+        wall = std::max(wall, jt[i * fields + 3]);
+        peak = std::max(peak, jt[i * fields + 4]);
+        cpu += jt[i * fields + 5];
+      }
+      if (it.isSource) {
+        out << "        rows out: " << (long long)rowsOut;
+      } else {
+        out << "        rows in: " << (long long)rowsIn << ", rows out: " << (long long)rowsOut
+            << ", time: " << std::fixed << std::setprecision(3) << wall * 1000 << " ms, cpu: "
+            << cpu * 1000 << " ms";
+        out.unsetf(std::ios::fixed);
+      }
+      if (!it.shuffle.empty()) out << ", bytes shuffled: " << (long long)bytes;
+      if (it.isTable) out << ", table peak: " << (long long)peak;
+      out << '\n';
+    }
+    ++i;
+  }
+  if (_analyze) {
+    double wall = 0, cpu = 0;
+    for (const auto &jt : all) {
+      wall = std::max(wall, jt[jt.size() - 2]);
+      cpu += jt[jt.size() - 1];
+    }
+    out << "total time: " << std::fixed << std::setprecision(3) << wall * 1000
+        << " ms, cpu: " << cpu * 1000 << " ms in " << all.size() << " process(es)\n";
+  }
+  std::cout << out.str();
+}
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <fstream>
 #include <assert.h>
+#include <cstdlib>
+#include <unistd.h>
 
 
 #include <helper.hpp>
@@ -111,36 +113,81 @@ bool client::helper::lexCastPawn(std::vector<std::string> &vstr,
   i = 0;
   for (auto it : colsNumeric)
   {
-    if (vstr[it - 1].empty() && strict)
+    if (!lexCastNumPawn(vstr[it - 1], std::get<1>(out)[i++], strict))
     {
       return false;
     }
-    try
-    {
-      std::get<1>(out)[i] = std::stod(vstr[it - 1]);
-      ++i;
-    }
-    catch (std::invalid_argument ex)
-    {
-      // Karta::inst().log("Invalid integer value.", LogMode::info);
-      if (strict)
-        return false;
-      std::get<1>(out)[i++] = 0;
-    }
-    catch (std::out_of_range ex)
-    {
-      // Karta::inst().log("Out of range integer value.", LogMode::info);
-      if (strict)
-        return false;
-      std::get<1>(out)[i++] = 0;
-    }
-    catch (...)
-    {
-      // Karta::inst().log("Unknown integer conversion error.", LogMode::info);
-      if (strict)
-        return false;
-      std::get<1>(out)[i++] = 0;
-    }
   }
   return true;
 };
+
+bool client::helper::lexCastNumPawn(const std::string &s, double &out, bool strict)
+{
+  if (s.empty() && strict)
+  {
+    return false;
+  }
+  try
+  {
+    out = std::stod(s);
+  }
+  catch (std::invalid_argument ex)
+  {
+    // Karta::inst().log("Invalid integer value.", LogMode::info);
+    if (strict)
+      return false;
+    out = 0;
+  }
+  catch (std::out_of_range ex)
+  {
+    // Karta::inst().log("Out of range integer value.", LogMode::info);
+    if (strict)
+      return false;
+    out = 0;
+  }
+  catch (...)
+  {
+    // Karta::inst().log("Unknown integer conversion error.", LogMode::info);
+    if (strict)
+      return false;
+    out = 0;
+  }
+  return true;
+}
+
+bool client::helper::sortedLess(const std::string &a, const std::string &b) {
+  auto number = [](const std::string &s, double &out) {
+    if (s.empty()) return false;
+    char *end;
+    out = std::strtod(s.c_str(), &end);
+    return *end == '\0';
+  };
+  double x, y;
+  auto isX = number(a, x);
+  auto isY = number(b, y);
+  if (isX && isY) return x < y;
+  if (isX != isY) return isX;
+  return a < b;
+}
+
+bool client::helper::readKeys(const std::string &fname, std::vector<std::string> &out)
+{
+  std::ifstream f(fname);
+  if (!f.is_open()) return false;
+  std::string line;
+  while (std::getline(f, line)) {
+    boost::trim(line);
+    if (!line.empty()) out.push_back(std::move(line));
+  }
+  return true;
+}
+
+size_t client::helper::reduceBudget(int nProc) {
+  if (auto mb = std::getenv("PAWN_REDUCE_MEMORY")) {
+    return size_t(std::strtoull(mb, nullptr, 10)) << 20;
+  }
+  auto pages = sysconf(_SC_PHYS_PAGES);
+  auto size = sysconf(_SC_PAGE_SIZE);
+  if (pages <= 0 || size <= 0) return 0;
+  return size_t(pages) * size_t(size) / 2 / size_t(std::max(nProc, 1));
+}
@@ -7,21 +7,30 @@
 #include <boost/algorithm/string/split.hpp>
 
 #include <ezl.hpp>
+#include <batchFilterPawn.hpp>
+#include <chunkOrderPawn.hpp>
 #include <fromFilePawn.hpp>
 
+#include <explain.hpp>
 #include <helper.hpp>
 #include <mast.hpp>
 #include <last.hpp>
 #include <lcast.hpp>
 #include <pawn_ast.hpp>
 #include <pawn_grammar.hpp>
+#include <pawn_planner.hpp>
+#include <sortPawn.hpp>
+#include <topPawn.hpp>
+#include <windowPawn.hpp>
+#include <treeReducePawn.hpp>
 
 using dataT = std::tuple<const std::vector<std::string>&, const std::vector<double>&>;
 using sourceT = std::shared_ptr<ezl::Source<dataT>>;
 
 std::vector<sourceT> sources;
 
-sourceT internalZip(client::pawn::ast::zipExpr&, std::vector<int> workers, client::helper::Global &global, int zCount);
+sourceT internalZip(client::pawn::ast::zipExpr&, std::vector<int> workers, client::helper::Global &global, int zCount,
+                    client::helper::Explain *explain);
 
 std::string sanityCheck(const client::helper::ColIndices& cols) { 
   if (cols.num.empty() && cols.str.empty()) {
@@ -51,6 +60,7 @@ auto cookAst(std::string str, const client::helper::Global &global) {
   boost::spirit::ascii::space_type space;
   bool r = phrase_parse(iter, end, calc, space, res);
   if (r && iter == end) {
+      client::pawn::ast::planner{global}(res);
       auto err = cols(res);
       if (err.size() > 0) {
         std::cout << err << '\n';
@@ -70,7 +80,57 @@ auto cookAst(std::string str, const client::helper::Global &global) {
   return std::make_pair(res, false);
 }
 
-auto getSource(client::pawn::ast::src &s, std::vector<int> workers, int zCount) {
+// Leading `where` filters can only refer to the input columns, these are
+// handed over to the reader to be evaluated on the raw tokens before the rest
+// of the row is converted. The last unit is left as it carries the dump.
+auto rawWhere(std::string inFile, std::list<client::pawn::ast::unit> &units,
+              const client::helper::Global &global) {
+  using client::helper::ColIndices;
+  using logicalExpr = client::logical::ast::expr;
+  using retFnT = client::logical::ast::evaluator::retFnT;
+  auto headers = client::helper::headerCols(inFile);
+  ColIndices none, cols;
+  client::logical::ast::colsEval lcols{none, global};
+  lcols.setHeaders(headers);
+  std::vector<logicalExpr> pushed;
+  while (units.size() > 1) {
+    auto f = boost::get<client::pawn::ast::filter>(&units.front());
+    if (!f) break;
+    auto l = boost::get<logicalExpr>(f);
+    if (!l) break;
+    cols.add(lcols(*l).first);
+    pushed.push_back(*l);
+    units.pop_front();
+  }
+  retFnT fn;
+  if (pushed.empty()) return std::make_pair(fn, cols.num);
+  cols.uniq();
+  cols.sort();
+  // strings are looked up in the raw tokens and numbers in the parsed subset
+  ColIndices raw;
+  if (!cols.str.empty()) {
+    raw.str.resize(cols.str.back());
+    std::iota(begin(raw.str), end(raw.str), 1);
+  }
+  raw.num = cols.num;
+  client::helper::processHeader(raw, headers);
+  client::logical::ast::evaluator leval{client::helper::positionTeller{raw}, global};
+  std::vector<retFnT> fns;
+  for (const auto &it : pushed) fns.push_back(leval(it));
+  if (fns.size() == 1) {
+    fn = std::move(fns[0]);
+  } else {
+    fn = [fns](const std::vector<std::string> &s, const std::vector<double> &v) {
+      for (const auto &f : fns) if (!f(s, v)) return false;
+      return true;
+    };
+  }
+  return std::make_pair(fn, raw.num);
+}
+
+sourceT getSource(client::pawn::ast::src &s, std::list<client::pawn::ast::unit> &units,
+                  std::vector<int> workers, int zCount, const client::helper::Global &global,
+                  client::helper::Explain *explain) {
   using ezl::rise; using ezl::fromFilePawn;
   std::vector<int> curWorkers;
   if (zCount == 0) {
@@ -87,7 +147,22 @@ auto getSource(client::pawn::ast::src &s, std::vector<int> workers, int zCount)
     if (curWorkers.empty()) curWorkers.push_back(workers[workers.size() - 1]);
   }
   std::string inFile{s.fname.begin() + 1, s.fname.end() - 1};
-  return rise(fromFilePawn(inFile, s.colIndices.str, s.colIndices.num)).prll(curWorkers).build();
+  auto nUnits = units.size();
+  auto where = rawWhere(inFile, units, global);
+  sourceT src = rise(fromFilePawn(inFile, s.colIndices.str, s.colIndices.num)
+                       .where(std::move(where.first), std::move(where.second)))
+                .prll(curWorkers).build();
+  if (explain) {
+    auto name = "file " + s.fname;
+    if (nUnits > units.size()) name += " where on raw tokens: " + std::to_string(nUnits - units.size());
+    auto st = explain->add(name, curWorkers);
+    if (st) {
+      st->isSource = true;
+      sources.push_back(src);
+      src = ezl::flow(src).filter(client::helper::RowCounter{st, false}).build();
+    }
+  }
+  return src;
 }
 
 struct AddUnits {
@@ -97,6 +172,12 @@ struct AddUnits {
   typedef client::pawn::ast::filter filterT;
   typedef client::pawn::ast::reduce reduceT;
   typedef client::pawn::ast::zipExpr zipT;
+  typedef client::pawn::ast::topBy topByT;
+  typedef client::pawn::ast::topCount topCountT;
+  typedef client::pawn::ast::sortNum sortNumT;
+  typedef client::pawn::ast::sortStr sortStrT;
+  typedef client::pawn::ast::window windowT;
+  typedef client::pawn::ast::dropVars dropVarsT;
   typedef void result_type;
   using mevalT = client::math::ast::evaluator;
   using levalT = client::logical::ast::evaluator;
@@ -123,45 +204,171 @@ struct AddUnits {
   std::vector<int> _workers;
   Global &_global;
   int _zCount;
-  AddUnits(std::string fn, bool isDump, std::vector<int> workers, Global &g, int zCount) : _posTell{_indices}, _meval{_posTell, g},
-          _leval{_posTell, g}, _aeval{_posTell}, _lcmd{}, _fname{fn}, _isDump{isDump}, _workers{workers}, _global{g}, _zCount{zCount} { }
+  client::helper::Explain *_explain;
+  AddUnits(std::string fn, bool isDump, std::vector<int> workers, Global &g, int zCount,
+           client::helper::Explain *explain = nullptr) : _posTell{_indices}, _meval{_posTell, g},
+          _leval{_posTell, g}, _aeval{_posTell}, _lcmd{}, _fname{fn}, _isDump{isDump}, _workers{workers}, _global{g},
+          _zCount{zCount}, _explain{explain} { }
+
+  // adds the unit to the explain plan, returns the counters if analyzing
+  client::helper::UnitStats *explain(std::string name, std::vector<int> ranks = {}, std::string shuffle = "") {
+    if (!_explain) return nullptr;
+    return _explain->add(std::move(name), std::move(ranks), std::move(shuffle));
+  }
+
+  // attaches the dump if required and counts the rows out if analyzing
+  template <class X> void finish(X &x, bool isShow, client::helper::UnitStats *st) {
+    if (isShow && _isSpread) {
+      finish(x, false, st);
+      return gather();
+    }
+    if (st) {
+      auto y = x.filter(client::helper::RowCounter{st, false});
+      if (isShow) y.dump(_fname, cookDumpHeader(_indices)); 
+      _cur = y.build();
+      return;
+    }
+    if (isShow) x.dump(_fname, cookDumpHeader(_indices)); 
+    _cur = x.build();
+  }
+
+  // rows are on all the workers after a keyed reduce, these are collected
+  // to rank 0 for the dump
+  bool _isSpread {false};
+  void gather() {
+    auto st = explain("gather for show", {0}, "to rank 0");
+    auto x = ezl::flow(_cur).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      client::helper::UnitTimer t{st};
+      t.out();
+      return true;
+    }).prll({0}, ezl::llmode::task);
+    _isSpread = false;
+    finish(x, true, nullptr);
+  }
+
+  // consecutive maps and filters are fused in a single unit, filters prior to
+  // the first map run on the incoming row and the rest on a copy of the
+  // numeric columns that the maps append to in place.
+  using predT = levalT::retFnT;
+  using stepT = std::function<bool(const std::vector<std::string>&, std::vector<double>&)>;
+  std::vector<predT> _preds;
+  std::vector<stepT> _steps;
+  std::string _fused;
 
   void operator()(mapT const &m) {
+    _fused += (_fused.empty() ? "$" : ", $") + m.identifier;
     auto fn = _meval(m.operation);
-    auto x = ezl::flow(_cur).map<2>([fn](std::vector<double> v) {
+    _steps.push_back([fn](const std::vector<std::string> &, std::vector<double> &v) {
       v.push_back(fn(v));
-      return std::make_tuple(v);
-    }).colsTransform();
-    if (_isShow) x.dump(_fname, cookDumpHeader(_indices)); 
-    _cur = x.build();
+      return true;
+    });
+  }
+
+  void addPred(predT fn) {
+    if (_steps.empty()) {
+      _preds.push_back(std::move(fn));
+      return;
+    }
+    _steps.push_back([fn](const std::vector<std::string> &s, std::vector<double> &v) {
+      return fn(s, v);
+    });
   }
 
   void operator()(logicalExpr const &f) {
-    auto fn = _leval(f);
-    auto x = ezl::flow(_cur).filter(std::move(fn));
-    if (_isShow) x.dump(_fname, cookDumpHeader(_indices)); 
-    _cur = x.build();
+    _fused += _fused.empty() ? "where" : ", where";
+    addPred(_leval(f));
   }
 
   void operator()(logicalCmd const &f) {
-    auto fn = _lcmd(f);
-    auto x = ezl::flow(_cur).filter(std::move(fn));
-    if (_isShow) x.dump(_fname, cookDumpHeader(_indices)); 
-    _cur = x.build();
+    if (_lcmd.isBatch(f)) return batchFilter(f);
+    _fused += _fused.empty() ? "where cmd" : ", where cmd";
+    addPred(_lcmd(f));
+  }
+
+  // a filter from a batch ABI library gets the rows in bunches, this ends
+  // the current fused run
+  void batchFilter(logicalCmd const &f) {
+    fuse(false);
+    auto st = explain("where cmd " + f.fn + " in batches of " + std::to_string(lcmdT::batchRows));
+    if (st) _cur = ezl::flow(_cur).filter(client::helper::RowCounter{st, true}).build();
+    auto unit = std::make_shared<ezl::BatchFilterPawn>(_lcmd.batch(f), lcmdT::batchRows);
+    unit->prev(_cur, unit);
+    auto y = ezl::flow(unit).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      if (st) ++st->rowsOut;
+      return true;
+    });
+    finish(y, _isShow, nullptr);
+  }
+
+  void fuse(bool isShow) {
+    if (_preds.empty() && _steps.empty()) return;
+    auto preds = std::move(_preds);
+    auto steps = std::move(_steps);
+    _preds.clear();
+    _steps.clear();
+    auto st = explain("map/filter: " + _fused);
+    _fused.clear();
+    auto pass = [preds](const std::vector<std::string> &s, const std::vector<double> &v) {
+      for (const auto &f : preds) if (!f(s, v)) return false;
+      return true;
+    };
+    if (steps.empty()) {
+      auto x = ezl::flow(_cur).filter([pass, st](const std::vector<std::string> &s, const std::vector<double> &v) {
+        client::helper::UnitTimer t{st};
+        if (!pass(s, v)) return false;
+        t.out();
+        return true;
+      });
+      return finish(x, isShow, nullptr);
+    }
+    auto x = ezl::flow(_cur).map<1, 2>([pass, steps, st](const std::vector<std::string> &s, const std::vector<double> &v) {
+      client::helper::UnitTimer t{st};
+      std::vector<std::tuple<std::vector<double>>> res;
+      if (!pass(s, v)) return res;
+      auto cur = v;
+      for (const auto &f : steps) if (!f(s, cur)) return res;
+      res.emplace_back(std::move(cur));
+      t.out();
+      return res;
+    }).colsDrop<2>();
+    finish(x, isShow, nullptr);
   }
 
   void operator()(filterT const &f) {
     return boost::apply_visitor(*this, f);
   }
 
+  // variables that no later unit reads are taken out of the rows in the
+  // fused run, the columns after them move up
+  void operator()(dropVarsT const &d) {
+    std::vector<int> pos;
+    for (const auto &it : d.vars) {
+      auto p = _posTell.var(it);
+      if (p < int(_indices.var.size())) pos.push_back(p);
+      _fused += (_fused.empty() ? "drop $" : ", drop $") + it;
+    }
+    std::sort(pos.rbegin(), pos.rend());
+    for (auto p : pos) {
+      _indices.var.erase(begin(_indices.var) + p);
+      if (p < int(_indices.num.size())) _indices.num.erase(begin(_indices.num) + p);
+    }
+    _steps.push_back([pos](const std::vector<std::string> &, std::vector<double> &v) {
+      for (auto p : pos) v.erase(begin(v) + p);
+      return true;
+    });
+  }
+
   void columnSelect(std::vector<size_t> vstr) {
     std::vector<int> keepIndices;
     for (auto it : vstr) {
       keepIndices.push_back(_posTell.str(it));
     }
-    auto fn = [keepIndices](const std::vector<std::string> &s) { 
+    auto st = explain("select keys");
+    auto fn = [keepIndices, st](const std::vector<std::string> &s) { 
+      client::helper::UnitTimer t{st};
       std::vector<std::string> res;
       for (auto it : keepIndices) res.push_back(s[it]);
+      t.out();
       return std::make_tuple(res);
     };
     _cur = ezl::flow(_cur).map<1>(std::move(fn)).colsTransform().build();
@@ -172,16 +379,137 @@ struct AddUnits {
     using resT = std::tuple<std::vector<double>>&;
     using keyT = const std::vector<std::string>&;
     using rowT = const std::vector<double>&;
+    fuse(false);
     if (r.colIndices.str.size() < _indices.str.size()) columnSelect(r.colIndices.str);
-    auto fl = internalZip(r, _workers, _global, _zCount);
+    auto fl = internalZip(r, _workers, _global, _zCount, _explain);
+    _sortedBy.clear();
+    auto st = explain("zip", {0}, "on keys " + client::helper::keysText(r.colIndices) + " from both sides to rank 0");
+    _isSpread = false;
+    if (st) {
+      _cur = ezl::flow(_cur).filter(client::helper::RowCounter{st, true}).build();
+      fl = ezl::flow(fl).filter(client::helper::RowCounter{st, true}).build();
+    }
     auto x = ezl::flow(_cur).zip<1>(std::move(fl)).prll({0}, ezl::llmode::task).colsDrop<3>()
                .map<2, 3>([](std::vector<double> v1, std::vector<double> v2) {
                  std::move(begin(v2), end(v2), std::back_inserter(v1));
                  return std::make_tuple(v1);
                }).colsTransform();
     _indices = r.colIndices;
-    if (_isShow) x.dump(_fname, cookDumpHeader(_indices)); 
-    _cur = x.build();
+    finish(x, _isShow, st);
+  }
+
+  // approx_distinct of a string column reads the hll code of the string
+  // from a numeric column that is appended along with the maps
+  void hllCodes(client::reduce::ast::expr const &e) {
+    using client::reduce::ast::variable;
+    for (const auto &it : client::reduce::ast::strOperands(e)) {
+      auto v = boost::get<variable>(&it);
+      auto pos = v ? _posTell.varStr(*v) : _posTell.str(boost::get<client::reduce::ast::column>(it));
+      auto name = client::reduce::ast::codeName(it);
+      _fused += (_fused.empty() ? "hll code of " : ", hll code of ") + name;
+      _steps.push_back([pos](const std::vector<std::string> &s, std::vector<double> &v) {
+        v.push_back(client::sketch::hll::code(client::sketch::hash(s[pos])));
+        return true;
+      });
+      _indices.var.push_back(name);
+    }
+  }
+
+  // the rows are copied for each of the grouping sets with "*" for the keys
+  // that are not in the set, the reduce on all the keys then has the groups
+  // of every set in its table. The grouping id of the set is the last key so
+  // that a "*" of the input is not taken for a key left out. It has a bit for
+  // each key that is left out, the first key in the highest bit.
+  void groupingSets(reduceT const &r) {
+    const auto &keys = r.colIndices.str;
+    std::vector<std::pair<std::vector<int>, std::string>> masked;
+    std::string name = "grouping sets";
+    for (const auto &it : r.setCols) {
+      ColIndices set;
+      std::vector<int> m;
+      size_t id = 0;
+      for (size_t i = 0; i < keys.size(); ++i) {
+        id <<= 1;
+        if (std::find(begin(it), end(it), keys[i]) == end(it)) {
+          m.push_back(i);
+          id |= 1;
+          continue;
+        }
+        set.str.push_back(keys[i]);
+        set.varStr.push_back(i < r.colIndices.varStr.size() ? r.colIndices.varStr[i] : "-");
+      }
+      name += " (" + client::helper::keysText(set) + ")";
+      masked.emplace_back(std::move(m), std::to_string(id));
+    }
+    auto st = explain(name);
+    auto fn = [masked, st](const std::vector<std::string> &s) {
+      client::helper::UnitTimer t{st};
+      std::vector<std::tuple<std::vector<std::string>>> res;
+      res.reserve(masked.size());
+      for (const auto &m : masked) {
+        auto k = s;
+        for (auto i : m.first) k[i] = "*";
+        k.push_back(m.second);
+        res.emplace_back(std::move(k));
+      }
+      t.out(res.size());
+      return res;
+    };
+    _cur = ezl::flow(_cur).map<1>(std::move(fn)).colsTransform().build();
+  }
+
+  // the grouping id is moved from the keys to the last numeric column
+  void groupingId() {
+    auto y = ezl::flow(_cur).map<1, 2>([](std::vector<std::string> s, std::vector<double> v) {
+      v.push_back(std::stod(s.back()));
+      s.pop_back();
+      return std::make_tuple(std::move(s), std::move(v));
+    }).colsTransform();
+    finish(y, _isShow, nullptr);
+  }
+
+  // string columns the rows in each process are sorted by, with the rows of a
+  // group adjacent for any of its prefixes. Maps and filters keep the order.
+  std::vector<size_t> _sortedBy;
+
+  // if the order is made in the query, by a sort or a reduce on sorted
+  // rows, rather than declared for the file
+  bool _isSortMade{false};
+
+  // if the keys are a prefix of the sorted columns in any order
+  bool isGrouped(const std::vector<size_t> &keys) const {
+    if (keys.empty() || keys.size() > _sortedBy.size()) return false;
+    return std::is_permutation(begin(keys), end(keys), begin(_sortedBy));
+  }
+
+  // the rows of a file declared sorted are checked to be in that order on
+  // the first n sorted columns, each key against the one before. A final
+  // reduce on sorted rows passes a group on as soon as the next begins and
+  // can not merge it if it comes again, so the query stops at the first row
+  // out of order with an error.
+  void checkOrder(size_t n) {
+    std::vector<int> pos;
+    for (size_t i = 0; i < n; ++i) pos.push_back(_posTell.str(_sortedBy[i]));
+    auto prev = std::make_shared<std::vector<std::string>>();
+    auto row = std::make_shared<size_t>(1);
+    _cur = ezl::flow(_cur).filter([pos, prev, row](const std::vector<std::string> &s, const std::vector<double> &) {
+      if (*row == 0) return false;
+      for (size_t i = 0; i < prev->size(); ++i) {
+        const auto &cur = s[pos[i]];
+        if ((*prev)[i] == cur) continue;
+        if (client::helper::sortedLess(cur, (*prev)[i])) {
+          std::cout << "Error: row " << *row << " is not in the sorted order declared for the file, "
+                    << "the query is stopped.\n";
+          *row = 0;
+          return false;
+        }
+        break;
+      }
+      prev->resize(pos.size());
+      for (size_t i = 0; i < pos.size(); ++i) (*prev)[i] = s[pos[i]];
+      ++*row;
+      return true;
+    }).build();
   }
 
   void operator()(reduceT const &r) { 
@@ -189,24 +517,283 @@ struct AddUnits {
     using resT = std::tuple<std::vector<double>>&;
     using keyT = const std::vector<std::string>&;
     using rowT = const std::vector<double>&;
+    hllCodes(r.operation);
+    fuse(false);
     if (r.colIndices.str.size() < _indices.str.size()) columnSelect(r.colIndices.str);
-    auto vf = _aeval(r.operation);
-    auto fn = [vf](resT r, keyT k, rowT c) -> auto& { for (const auto &f : vf) f(r, k, c); return r; };
-    auto initial = std::make_tuple(std::vector<double>(vf.size()));
-    auto x = ezl::flow(_cur).reduce<1>(std::move(fn), std::move(initial)).inprocess();
+    if (!r.setCols.empty()) groupingSets(r);
+    auto keys = client::helper::keysText(r.colIndices);
+    auto label = keys.empty() ? keys : " " + keys;
+    auto agg = _aeval(r.operation);
+    // on sorted rows a group is passed on as soon as the next begins, the
+    // final reduce merges a group that is split over the processes. It is
+    // in order as well if it is in the same single process.
+    auto grouped = r.setCols.empty() && isGrouped(r.colIndices.str);
+    auto finalGrouped = grouped && _workers.size() == 1;
+    if (finalGrouped && !_isSortMade) checkOrder(r.colIndices.str.size());
+    _isSortMade = finalGrouped;
+    _sortedBy.resize(finalGrouped ? r.colIndices.str.size() : 0);
+    auto pst = explain("reduce partial" + label + (grouped ? " on sorted rows" : ""));
+    if (pst) pst->isTable = true;
+    auto fn = [agg, pst](resT r, keyT k, rowT c) -> auto& {
+      client::helper::UnitTimer t{pst};
+      return agg(r, k, c);
+    };
+    auto initial = std::make_tuple(_aeval.initial(r.operation));
+    auto budget = client::helper::reduceBudget(ezl::Karta::inst().nProc());
+    // rows bypass the partial table when nearly every key is new
+    auto x = ezl::flow(_cur).reduce<1>(std::move(fn), std::move(initial)).spill(budget).partial().ordered(grouped)
+               .peak(pst ? &pst->tablePeak : nullptr).inprocess();
+    finish(x, false, pst);
     _aeval.sameIndex();
-    vf = _aeval(r.operation);
-    auto fn2 = [vf](resT r, keyT k, rowT c) -> auto& { for (const auto &f : vf) f(r, k, c); return r; };
-    initial = std::make_tuple(std::vector<double>(vf.size()));
-    auto y = x.reduce<1>(std::move(fn2), std::move(initial)).prll({0}, ezl::llmode::task);
-    _aeval.sameIndex(false);
+    agg = _aeval(r.operation);
     _indices = r.colIndices;
-    if (_isShow) y.dump(_fname, cookDumpHeader(_indices)); 
-    _cur = y.build();
+    if (keys.empty() && r.setCols.empty()) return treeReduce(std::move(agg), _aeval.finalize(r.operation));
+    // keyed groups are combined on the workers they hash to
+    auto st = explain("reduce final" + label + (finalGrouped ? " on sorted rows" : ""), _workers,
+                      (keys.empty() ? "on the grouping sets" : "on keys " + keys) + " across the workers");
+    if (st) st->isTable = true;
+    auto fn2 = [agg, st](resT r, keyT k, rowT c) -> auto& {
+      client::helper::UnitTimer t{st};
+      if (st) st->bytes += client::helper::rowBytes(k, c);
+      return agg(r, k, c);
+    };
+    initial = std::make_tuple(_aeval.initial(r.operation));
+    auto y = ezl::flow(_cur).reduce<1>(std::move(fn2), std::move(initial)).spill(budget).ordered(finalGrouped)
+               .peak(st ? &st->tablePeak : nullptr).prll(_workers, ezl::llmode::task);
+    _isSpread = _workers.size() > 1;
+    _aeval.sameIndex(false);
+    auto fin = _aeval.finalize(r.operation);
+    auto isSets = !r.setCols.empty();
+    if (!fin && !isSets) return finish(y, _isShow, st);
+    finish(y, false, st);
+    if (fin) finalize(fin, keys, !isSets);
+    if (isSets) groupingId();
+  }
+
+  // the single partial row of a keyless reduce in each process is combined
+  // in a binomial tree over the processes instead of sending all of them to
+  // rank 0, the result is in the first of the processes.
+  void treeReduce(aevalT::retFnT agg, aevalT::finalFnT fin) {
+    _aeval.sameIndex(false);
+    auto st = explain("reduce final", {}, "binomial tree over the processes");
+    auto merge = [agg, st](std::vector<double> &a, const std::vector<double> &b) {
+      client::helper::UnitTimer t{st, 0};
+      std::tuple<std::vector<double>> r{std::move(a)};
+      agg(r, {}, b);
+      a = std::move(std::get<0>(r));
+    };
+    auto tree = std::make_shared<ezl::TreeReducePawn>(std::move(merge));
+    if (st) _cur = ezl::flow(_cur).filter(client::helper::RowCounter{st, true}).build();
+    tree->prev(_cur, tree);
+    _isSpread = _workers.size() > 1;
+    auto y = ezl::flow(tree).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      if (st) ++st->rowsOut;
+      return true;
+    });
+    if (!fin) return finish(y, _isShow, nullptr);
+    finish(y, false, nullptr);
+    finalize(fin, "");
+  }
+
+  void finalize(aevalT::finalFnT fin, const std::string &keys, bool isShow = true) {
+    auto fst = explain("reduce finalize" + (keys.empty() ? keys : " " + keys));
+    auto z = ezl::flow(_cur).map<2>([fin, fst](const std::vector<double> &v) {
+      client::helper::UnitTimer t{fst};
+      t.out();
+      return std::make_tuple(fin(v));
+    }).colsTransform();
+    finish(z, _isShow && isShow, nullptr);
+  }
+
+  // the unit keeps a bounded state in each process and passes on only that,
+  // the rows of all the processes go through it once more on rank 0
+  template <class U> void twoPhase(std::shared_ptr<U> part, std::shared_ptr<U> all,
+                                   const std::string &name, const std::string &shuffle) {
+    auto pst = explain(name + " partial");
+    if (pst) _cur = ezl::flow(_cur).filter(client::helper::RowCounter{pst, true}).build();
+    part->prev(_cur, part);
+    _cur = ezl::flow(part).build();
+    if (pst) _cur = ezl::flow(_cur).filter(client::helper::RowCounter{pst, false}).build();
+    auto st = explain(name, {0}, shuffle);
+    sourceT y = ezl::flow(_cur).filter([st](const std::vector<std::string> &s, const std::vector<double> &v) {
+      if (st) client::helper::RowCounter{st, true}(s, v);
+      return true;
+    }).prll({0}, ezl::llmode::task).build();
+    all->prev(y, all);
+    _isSpread = false;
+    auto z = ezl::flow(all).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      if (st) ++st->rowsOut;
+      return true;
+    });
+    finish(z, _isShow, nullptr);
+  }
+
+  void operator()(topByT const &t) {
+    fuse(false);
+    _sortedBy.clear();
+    auto v = boost::get<std::string>(&t.col);
+    auto pos = v ? _posTell.var(*v) : _posTell.num(boost::get<unsigned int>(t.col));
+    auto name = "top " + std::to_string(t.n) + " by $" + (v ? *v : std::to_string(boost::get<unsigned int>(t.col)))
+                + (t.desc ? " desc" : "");
+    twoPhase(std::make_shared<ezl::TopPawn>(t.n, pos, t.desc), std::make_shared<ezl::TopPawn>(t.n, pos, t.desc),
+             name, std::to_string(t.n) + " rows per process to rank 0");
+  }
+
+  // Space-Saving counters in each process, with many more of them than the
+  // keys asked for so that the counts of those are seldom off
+  static constexpr size_t hitterCounters = 1024;
+
+  void operator()(topCountT const &t) {
+    fuse(false);
+    if (t.colIndices.str.size() < _indices.str.size()) columnSelect(t.colIndices.str);
+    auto keys = client::helper::keysText(t.colIndices);
+    auto cap = std::max(size_t(t.n) * 10, hitterCounters);
+    _sortedBy.clear();
+    _indices = t.colIndices;
+    twoPhase(std::make_shared<ezl::HeavyHittersPawn>(cap, cap, false),
+             std::make_shared<ezl::HeavyHittersPawn>(cap, t.n, true),
+             "top " + std::to_string(t.n) + (keys.empty() ? keys : " " + keys) + " by count", "counters of each process to rank 0");
+  }
+
+  // sample sort, each process sorts its rows and a splitter for each worker
+  // is picked from samples of these. The rows are range partitioned to the
+  // workers so that the sorted runs are in the order of the workers, the
+  // runs are merged on rank 0 if shown.
+  template <class K> void sampleSort(std::function<K(const std::vector<std::string>&, const std::vector<double>&)> key,
+                                     bool desc, const std::string &name) {
+    fuse(false);
+    auto splitters = std::make_shared<std::vector<K>>();
+    auto pst = explain(name + " local");
+    if (pst) _cur = ezl::flow(_cur).filter(client::helper::RowCounter{pst, true}).build();
+    auto local = std::make_shared<ezl::SortPawn<K>>(key, desc, _workers.size(), splitters);
+    local->prev(_cur, local);
+    auto st = explain(name, _workers, "ranges from samples across the workers");
+    sourceT x = ezl::flow(local).filter([pst, st](const std::vector<std::string> &s, const std::vector<double> &v) {
+      if (pst) ++pst->rowsOut;
+      if (st) client::helper::RowCounter{st, true}(s, v);
+      return true;
+    }).template partitionBy<1, 2>(ezl::RangePartition<K>{splitters, key, desc}).prll(_workers, ezl::llmode::task).build();
+    auto run = std::make_shared<ezl::SortPawn<K>>(key, desc);
+    run->prev(x, run);
+    _cur = ezl::flow(run).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      if (st) ++st->rowsOut;
+      return true;
+    }).build();
+    _isSpread = _workers.size() > 1;
+    if (!_isShow || !_isSpread) {
+      auto y = ezl::flow(_cur).filter([](const std::vector<std::string> &, const std::vector<double> &) { return true; });
+      return finish(y, _isShow, nullptr);
+    }
+    auto mst = explain(name + " merge", {0}, "runs to rank 0");
+    sourceT y = ezl::flow(_cur).filter([mst](const std::vector<std::string> &s, const std::vector<double> &v) {
+      if (mst) client::helper::RowCounter{mst, true}(s, v);
+      return true;
+    }).prll({0}, ezl::llmode::task).build();
+    auto merge = std::make_shared<ezl::SortPawn<K>>(key, desc);
+    merge->prev(y, merge);
+    _isSpread = false;
+    auto z = ezl::flow(merge).filter([mst](const std::vector<std::string> &, const std::vector<double> &) {
+      if (mst) ++mst->rowsOut;
+      return true;
+    });
+    finish(z, true, nullptr);
+  }
+
+  void operator()(sortNumT const &t) {
+    auto v = boost::get<std::string>(&t.col);
+    auto pos = v ? _posTell.var(*v) : _posTell.num(boost::get<unsigned int>(t.col));
+    auto name = "sort by $" + (v ? *v : std::to_string(boost::get<unsigned int>(t.col))) + (t.desc ? " desc" : "");
+    _sortedBy.clear();
+    sampleSort<double>([pos](const std::vector<std::string> &, const std::vector<double> &v) { return v[pos]; },
+                       t.desc, name);
+  }
+
+  void operator()(sortStrT const &t) {
+    std::vector<int> pos;
+    auto name = std::string{"sort by"};
+    // the rows of each worker are then sorted on the keys before the first
+    // one that is not a column of the file
+    _sortedBy.clear();
+    _isSortMade = true;
+    auto isPrefix = true;
+    for (const auto &it : t.keys) {
+      auto v = boost::get<std::string>(&it);
+      pos.push_back(v ? _posTell.varStr(*v) : _posTell.str(boost::get<unsigned int>(it)));
+      isPrefix = isPrefix && !v;
+      if (isPrefix) _sortedBy.push_back(boost::get<unsigned int>(it));
+    }
+    for (const auto &it : t.cols) {
+      auto v = boost::get<std::string>(&it);
+      name += " %" + (v ? *v : std::to_string(boost::get<unsigned int>(it)));
+    }
+    if (t.desc) name += " desc";
+    using keyT = std::vector<std::string>;
+    sampleSort<keyT>([pos](const std::vector<std::string> &s, const std::vector<double> &) {
+      keyT k;
+      for (auto i : pos) k.push_back(s[i]);
+      return k;
+    }, t.desc, name);
+  }
+
+  // the rows of all the processes are passed on in rank 0 in the order of
+  // the ranks, that is the order of the file for the chunks that the
+  // processes read or the order of a sort across the workers
+  void chunkOrder() {
+    auto st = explain("gather in order", {0}, "to rank 0 in the order of the ranks");
+    auto tag = std::make_shared<ezl::ChunkTagPawn>(ezl::Karta::inst().rank());
+    tag->prev(_cur, tag);
+    sourceT x = ezl::flow(tag).filter([st](const std::vector<std::string> &s, const std::vector<double> &v) {
+      if (st) client::helper::RowCounter{st, true}(s, v);
+      return true;
+    }).prll({0}, ezl::llmode::task).build();
+    auto order = std::make_shared<ezl::ChunkOrderPawn>();
+    order->prev(x, order);
+    _isSpread = false;
+    _cur = ezl::flow(order).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      if (st) ++st->rowsOut;
+      return true;
+    }).build();
+  }
+
+  // aggregates over the last rows in the order of the rows, on more
+  // processes the window is run on rank 0 after the rows are in order
+  void operator()(windowT const &w) {
+    fuse(false);
+    auto isGathered = ezl::Karta::inst().nProc() > 1;
+    if (isGathered) chunkOrder();
+    std::vector<int> keys;
+    auto name = "window " + std::to_string(w.n);
+    for (const auto &it : w.keys) {
+      auto v = boost::get<std::string>(&it);
+      keys.push_back(v ? _posTell.varStr(*v) : _posTell.str(boost::get<unsigned int>(it)));
+    }
+    for (const auto &it : w.cols) {
+      auto v = boost::get<std::string>(&it);
+      name += " %" + (v ? *v : std::to_string(boost::get<unsigned int>(it)));
+    }
+    std::vector<std::pair<ezl::WindowPawn::Op, int>> aggs;
+    for (const auto &it : w.aggs) {
+      auto v = boost::get<std::string>(&it.col);
+      auto pos = v ? _posTell.var(*v) : _posTell.num(boost::get<unsigned int>(it.col));
+      aggs.emplace_back(ezl::WindowPawn::Op(int(it.op)), pos);
+      name += " " + client::pawn::ast::windowName(it, {});
+    }
+    auto st = isGathered ? explain(name, {0}) : explain(name);
+    if (st) _cur = ezl::flow(_cur).filter(client::helper::RowCounter{st, true}).build();
+    auto unit = std::make_shared<ezl::WindowPawn>(w.n, std::move(keys), std::move(aggs));
+    unit->prev(_cur, unit);
+    auto y = ezl::flow(unit).filter([st](const std::vector<std::string> &, const std::vector<double> &) {
+      if (st) ++st->rowsOut;
+      return true;
+    });
+    finish(y, _isShow, nullptr);
   }
 
-  sourceT operator()(sourceT &src, client::helper::ColIndices &colIndices, std::list<client::pawn::ast::unit>& units) {
+  sourceT operator()(sourceT &src, client::helper::ColIndices &colIndices, std::list<client::pawn::ast::unit>& units,
+                     std::vector<size_t> sortedBy = {}) {
     _indices = colIndices;
+    _sortedBy = std::move(sortedBy);
+    _isSortMade = false;
     _cur = src;
     _isShow = false;
     auto i = 0;
@@ -214,6 +801,7 @@ struct AddUnits {
       if (i++ == units.size() - 1) _isShow = _isDump;
       boost::apply_visitor(*this, it);
     }
+    fuse(_isShow);
     return _cur;
   }
 };
@@ -317,11 +905,12 @@ public:
   result_type operator()(const saveVal& s) const { return std::make_pair("", terminalType::val); }
 };
 
-sourceT internalZip(client::pawn::ast::zipExpr &expression, std::vector<int> workers, client::helper::Global &global, int zCount) {
-  sourceT src = getSource(expression.first,  workers, zCount);
+sourceT internalZip(client::pawn::ast::zipExpr &expression, std::vector<int> workers, client::helper::Global &global, int zCount,
+                    client::helper::Explain *explain) {
+  sourceT src = getSource(expression.first, expression.units, workers, zCount, global, explain);
   sources.push_back(src);
-  AddUnits addUnits{"", false, workers, global, zCount};
-  auto cur = addUnits(src, expression.first.colIndices, expression.units);
+  AddUnits addUnits{"", false, workers, global, zCount, explain};
+  auto cur = addUnits(src, expression.first.colIndices, expression.units, expression.first.sortedCols);
   return cur;
 }
 
@@ -337,10 +926,22 @@ auto readQuery(std::string line, std::vector<int> workers, client::helper::Globa
     global.gQueries[terminalInfo.first] = line;
     return true;
   }
-  sourceT src = getSource(expression.first, workers, expression.zipCount);
-  AddUnits addUnits{terminalInfo.first, true, workers, global, expression.zipCount};
-  auto cur = addUnits(src, expression.first.colIndices, expression.units);
-  runFlow(cur, workers, terminalInfo.second == terminalType::val, expression, global);
+  using client::pawn::ast::explainT;
+  std::unique_ptr<client::helper::Explain> explain;
+  if (expression.explain != explainT::none) {
+    explain = std::make_unique<client::helper::Explain>(expression.explain == explainT::analyze);
+  }
+  // rows shown on the terminal are skipped when analyzing
+  auto isDump = !explain || !terminalInfo.first.empty();
+  sourceT src = getSource(expression.first, expression.units, workers, expression.zipCount, global, explain.get());
+  AddUnits addUnits{terminalInfo.first, isDump, workers, global, expression.zipCount, explain.get()};
+  auto cur = addUnits(src, expression.first.colIndices, expression.units, expression.first.sortedCols);
+  if (!explain || explain->analyze()) {
+    if (explain) explain->start();
+    runFlow(cur, workers, terminalInfo.second == terminalType::val, expression, global);
+    if (explain) explain->stop();
+  }
+  if (explain) explain->print();
   sources.clear();
   return true;
 }